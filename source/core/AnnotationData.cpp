@@ -1,10 +1,71 @@
 #include "AnnotationData.h"
+#include <algorithm>
+
+// Folds change into pending when the two describe one contiguous range
+static bool coalesce(AnnotationData::Change& pending, const AnnotationData::Change& change)
+{
+    using Change = AnnotationData::Change;
+    if (change.kind != pending.kind || change.kind == Change::Reset)
+        return false;
+
+    if (change.kind == Change::Inserted) {
+        // Right after the pending rows, or right before them
+        if (change.first == pending.first + pending.count || change.first == pending.first) {
+            pending.count += change.count;
+            return true;
+        }
+        return false;
+    }
+
+    // Removed: the rows that moved up into the pending gap, or those just
+    // before it
+    if (change.first == pending.first) {
+        pending.count += change.count;
+        return true;
+    }
+    if (change.first + change.count == pending.first) {
+        pending.first = change.first;
+        pending.count += change.count;
+        return true;
+    }
+    return false;
+}
 
 AnnotationData::AnnotationData(QObject* parent)
     : QObject(parent)
 {
 }
 
+void AnnotationData::endUpdate()
+{
+    if (--m_updateDepth > 0)
+        return;
+    flush(m_pendingActive, &AnnotationData::activeAnnotationsChanged);
+    flush(m_pendingSegments, &AnnotationData::segmentsChanged);
+}
+
+void AnnotationData::announce(PendingChange& pending, const Change& change, ChangeSignal signal)
+{
+    if (m_updateDepth == 0) {
+        emit (this->*signal)(change);
+        return;
+    }
+    if (!pending.active) {
+        pending.active = true;
+        pending.change = change;
+    } else if (!coalesce(pending.change, change)) {
+        pending.change = Change();
+    }
+}
+
+void AnnotationData::flush(PendingChange& pending, ChangeSignal signal)
+{
+    if (!pending.active)
+        return;
+    pending.active = false;
+    emit (this->*signal)(pending.change);
+}
+
 void AnnotationData::addLabel(const LabelDef& label)
 {
     m_labels.push_back(label);
@@ -44,29 +105,139 @@ int AnnotationData::nextLabelId()
     return m_nextLabelId++;
 }
 
-void AnnotationData::addFrameAnnotation(const FrameAnnotation& fa)
+void AnnotationData::addFrameAnnotation(FrameAnnotationPtr fa)
+{
+    m_activeAnnotations.push_back(std::move(fa));
+    announce(m_pendingActive, {Change::Inserted, static_cast<int>(m_activeAnnotations.size()) - 1, 1},
+             &AnnotationData::activeAnnotationsChanged);
+}
+
+void AnnotationData::setActiveAnnotations(std::vector<FrameAnnotationPtr> annotations)
+{
+    m_activeAnnotations = std::move(annotations);
+    announce(m_pendingActive, Change(), &AnnotationData::activeAnnotationsChanged);
+}
+
+void AnnotationData::sortActiveAnnotations()
 {
-    m_activeAnnotations.push_back(fa);
-    emit activeAnnotationsChanged();
+    // Only pointers move; backward results arrive interleaved with forward ones
+    auto byFrame = [](const FrameAnnotationPtr& a, const FrameAnnotationPtr& b) {
+        return a->frameIndex < b->frameIndex;
+    };
+    if (std::is_sorted(m_activeAnnotations.begin(), m_activeAnnotations.end(), byFrame))
+        return;
+    std::stable_sort(m_activeAnnotations.begin(), m_activeAnnotations.end(), byFrame);
+    announce(m_pendingActive, Change(), &AnnotationData::activeAnnotationsChanged);
+}
+
+void AnnotationData::truncateActiveAnnotations(int lastFrame)
+{
+    auto it = std::remove_if(m_activeAnnotations.begin(), m_activeAnnotations.end(),
+                             [lastFrame](const FrameAnnotationPtr& fa) { return fa->frameIndex > lastFrame; });
+    if (it != m_activeAnnotations.end()) {
+        // The dropped frames need not have been the last rows
+        m_activeAnnotations.erase(it, m_activeAnnotations.end());
+        announce(m_pendingActive, Change(), &AnnotationData::activeAnnotationsChanged);
+    }
 }
 
 void AnnotationData::clearActiveAnnotations()
 {
+    int count = static_cast<int>(m_activeAnnotations.size());
     m_activeAnnotations.clear();
     m_trackingStartFrame = 0;
-    emit activeAnnotationsChanged();
+    if (count > 0)
+        announce(m_pendingActive, {Change::Removed, 0, count},
+                 &AnnotationData::activeAnnotationsChanged);
 }
 
-void AnnotationData::acceptSegment(const ResultSegment& seg)
+const ResultSegment& AnnotationData::acceptSegment(ResultSegment seg)
 {
-    m_segments.push_back(seg);
-    emit segmentsChanged();
+    m_segments.push_back(std::move(seg));
+    const ResultSegment& stored = m_segments.back();
+    m_segmentIndex.insert(stored.segmentId, stored.startFrame, stored.endFrame);
+    announce(m_pendingSegments, {Change::Inserted, static_cast<int>(m_segments.size()) - 1, 1},
+             &AnnotationData::segmentsChanged);
+    return stored;
 }
 
 void AnnotationData::removeSegment(int index)
 {
     if (index >= 0 && index < static_cast<int>(m_segments.size())) {
+        const ResultSegment& seg = m_segments[index];
+        m_segmentIndex.remove(seg.segmentId, seg.startFrame, seg.endFrame);
         m_segments.erase(m_segments.begin() + index);
-        emit segmentsChanged();
+        announce(m_pendingSegments, {Change::Removed, index, 1}, &AnnotationData::segmentsChanged);
+    }
+}
+
+const ResultSegment* AnnotationData::segmentById(int id) const
+{
+    // Ids are handed out in increasing order and segments are appended
+    auto it = std::lower_bound(m_segments.begin(), m_segments.end(), id,
+                               [](const ResultSegment& seg, int value) { return seg.segmentId < value; });
+    if (it == m_segments.end() || it->segmentId != id)
+        return nullptr;
+    return &*it;
+}
+
+AnnotationData::IdCounters AnnotationData::idCounters() const
+{
+    IdCounters counters;
+    counters.nextTrackId = m_nextTrackId;
+    counters.nextLabelId = m_nextLabelId;
+    counters.nextSegmentId = m_nextSegmentId;
+    return counters;
+}
+
+void AnnotationData::restore(std::vector<LabelDef> labels, std::vector<ResultSegment> segments,
+                             const IdCounters& counters)
+{
+    UpdateBatch batch(this);
+
+    m_labels = std::move(labels);
+    m_segments = std::move(segments);
+    std::stable_sort(m_segments.begin(), m_segments.end(),
+                     [](const ResultSegment& a, const ResultSegment& b) {
+                         return a.segmentId < b.segmentId;
+                     });
+    m_segmentIndex.clear();
+    for (const auto& seg : m_segments)
+        m_segmentIndex.insert(seg.segmentId, seg.startFrame, seg.endFrame);
+
+    // Counters never go backwards past an id that is already in use
+    m_nextTrackId = counters.nextTrackId;
+    m_nextLabelId = counters.nextLabelId;
+    m_nextSegmentId = counters.nextSegmentId;
+    for (const auto& label : m_labels)
+        m_nextLabelId = std::max(m_nextLabelId, label.id + 1);
+    for (const auto& seg : m_segments) {
+        m_nextSegmentId = std::max(m_nextSegmentId, seg.segmentId + 1);
+        BoxTable::Column<int> tracks = seg.boxes.tracks(); // ascending
+        if (!tracks.empty())
+            m_nextTrackId = std::max(m_nextTrackId, tracks[tracks.size() - 1] + 1);
+    }
+
+    clearActiveAnnotations();
+    emit labelsChanged();
+    announce(m_pendingSegments, Change(), &AnnotationData::segmentsChanged);
+}
+
+void AnnotationData::detachSegments()
+{
+    // Same boxes, so nothing to announce
+    for (auto& seg : m_segments)
+        seg.boxes = seg.boxes.detached();
+}
+
+std::vector<BoundingBox> AnnotationData::groundTruthAt(int frame) const
+{
+    std::vector<BoundingBox> boxes;
+    for (int id : m_segmentIndex.segmentsAt(frame)) {
+        if (const ResultSegment* seg = segmentById(id)) {
+            std::vector<BoundingBox> segBoxes = seg->boxes.boxesAt(frame);
+            boxes.insert(boxes.end(), segBoxes.begin(), segBoxes.end());
+        }
     }
+    return boxes;
 }
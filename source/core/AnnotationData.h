@@ -5,7 +5,10 @@
 #include <QImage>
 #include <QRectF>
 #include <QString>
+#include <memory>
 #include <vector>
+#include "BoxTable.h"
+#include "SegmentIndex.h"
 
 struct LabelDef {
     int     id = 0;
@@ -26,20 +29,50 @@ struct FrameAnnotation {
     std::vector<BoundingBox> boxes;
 };
 
+// A tracked frame is built once and never modified afterwards; the worker,
+// the renderer, the view and the active session all share the same record
+using FrameAnnotationPtr = std::shared_ptr<const FrameAnnotation>;
+
 struct ResultSegment {
     int                              segmentId = 0;
     QString                          title;
     int                              startFrame = 0;
     int                              endFrame = 0;
     QImage                           thumbnail;
-    std::vector<FrameAnnotation>     annotations;
+    BoxTable                         boxes;
 };
 
 class AnnotationData : public QObject {
     Q_OBJECT
 public:
+    // What a change signal covers: count rows from first were inserted or
+    // removed. Reset means anything may have changed, order included.
+    struct Change {
+        enum Kind { Inserted, Removed, Reset };
+        Kind kind = Reset;
+        int  first = 0;
+        int  count = 0;
+    };
+
+    // Holds change signals back for its lifetime. Changes to a collection
+    // are then announced once, as one range when they are contiguous and
+    // as a Reset otherwise. Batches nest.
+    class UpdateBatch {
+    public:
+        explicit UpdateBatch(AnnotationData* data) : m_data(data) { m_data->beginUpdate(); }
+        ~UpdateBatch() { m_data->endUpdate(); }
+        UpdateBatch(const UpdateBatch&) = delete;
+        UpdateBatch& operator=(const UpdateBatch&) = delete;
+
+    private:
+        AnnotationData* m_data;
+    };
+
     explicit AnnotationData(QObject* parent = nullptr);
 
+    void beginUpdate() { ++m_updateDepth; }
+    void endUpdate();
+
     // Label management
     void addLabel(const LabelDef& label);
     void removeLabel(int labelId);
@@ -49,30 +82,74 @@ public:
     int nextLabelId();
 
     // Active tracking session (not yet accepted)
-    std::vector<FrameAnnotation>& activeAnnotations() { return m_activeAnnotations; }
-    void addFrameAnnotation(const FrameAnnotation& fa);
+    const std::vector<FrameAnnotationPtr>& activeAnnotations() const { return m_activeAnnotations; }
+    void addFrameAnnotation(FrameAnnotationPtr fa);
+    void setActiveAnnotations(std::vector<FrameAnnotationPtr> annotations);
+    void sortActiveAnnotations(); // by frame, stable
+    void truncateActiveAnnotations(int lastFrame); // drops frames after lastFrame
     void clearActiveAnnotations();
     void setTrackingStartFrame(int frame) { m_trackingStartFrame = frame; }
     int trackingStartFrame() const { return m_trackingStartFrame; }
 
     // Finalized segments
-    void acceptSegment(const ResultSegment& seg);
+    const ResultSegment& acceptSegment(ResultSegment seg);
     const std::vector<ResultSegment>& segments() const { return m_segments; }
     void removeSegment(int index);
+    int nextSegmentId() { return m_nextSegmentId++; }
+    const ResultSegment* segmentById(int id) const;
+
+    // Frame coverage of the accepted segments, kept up to date by
+    // acceptSegment() and removeSegment()
+    const SegmentIndex& segmentIndex() const { return m_segmentIndex; }
+    std::vector<BoundingBox> groundTruthAt(int frame) const;
 
     // Track ID management
     int nextTrackId() { return m_nextTrackId++; }
 
+    // Id counters, saved with a project so restored ids are not handed out
+    // a second time
+    struct IdCounters {
+        int nextTrackId = 1;
+        int nextLabelId = 1;
+        int nextSegmentId = 0;
+    };
+    IdCounters idCounters() const;
+
+    // Replaces labels, segments and counters, e.g. with a loaded project,
+    // and drops the active session
+    void restore(std::vector<LabelDef> labels, std::vector<ResultSegment> segments,
+                 const IdCounters& counters);
+
+    // Gives every segment its own copy of its boxes, releasing the project
+    // file they were mapped from
+    void detachSegments();
+
 signals:
     void labelsChanged();
-    void segmentsChanged();
-    void activeAnnotationsChanged();
+    void segmentsChanged(const AnnotationData::Change& change);
+    void activeAnnotationsChanged(const AnnotationData::Change& change);
 
 private:
-    std::vector<LabelDef>        m_labels;
-    std::vector<FrameAnnotation> m_activeAnnotations;
-    std::vector<ResultSegment>   m_segments;
-    int                          m_nextTrackId = 1;
-    int                          m_nextLabelId = 1;
-    int                          m_trackingStartFrame = 0;
+    using ChangeSignal = void (AnnotationData::*)(const Change&);
+
+    // Change held back by an open batch
+    struct PendingChange {
+        bool   active = false;
+        Change change;
+    };
+
+    void announce(PendingChange& pending, const Change& change, ChangeSignal signal);
+    void flush(PendingChange& pending, ChangeSignal signal);
+
+    std::vector<LabelDef>           m_labels;
+    std::vector<FrameAnnotationPtr> m_activeAnnotations;
+    std::vector<ResultSegment>      m_segments; // ascending segmentId
+    SegmentIndex                    m_segmentIndex;
+    int                             m_nextTrackId = 1;
+    int                             m_nextLabelId = 1;
+    int                             m_nextSegmentId = 0;
+    int                             m_trackingStartFrame = 0;
+    int                             m_updateDepth = 0;
+    PendingChange                   m_pendingActive;
+    PendingChange                   m_pendingSegments;
 };
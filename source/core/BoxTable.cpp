@@ -0,0 +1,270 @@
+#include "BoxTable.h"
+#include "AnnotationData.h"
+#include <algorithm>
+#include <functional>
+#include <numeric>
+
+template <typename T>
+static void permute(std::vector<T>& column, const std::vector<int>& order)
+{
+    std::vector<T> permuted;
+    permuted.reserve(order.size());
+    for (int row : order)
+        permuted.push_back(column[row]);
+    column = std::move(permuted);
+}
+
+template <typename T>
+static BoxTable::Column<T> view(const std::vector<T>& array)
+{
+    return BoxTable::Column<T>(array.data(), static_cast<int>(array.size()));
+}
+
+// Non-decreasing from 0 up to total
+static bool isOffsetTable(const BoxTable::Column<int>& offsets, int total)
+{
+    if (offsets.empty() || offsets[0] != 0 || offsets[offsets.size() - 1] != total)
+        return false;
+    return std::is_sorted(offsets.begin(), offsets.end());
+}
+
+void BoxTable::Builder::reserve(size_t rows)
+{
+    m_storage.frame.reserve(rows);
+    m_storage.trackId.reserve(rows);
+    m_storage.labelId.reserve(rows);
+    m_storage.x.reserve(rows);
+    m_storage.y.reserve(rows);
+    m_storage.width.reserve(rows);
+    m_storage.height.reserve(rows);
+    m_storage.confidence.reserve(rows);
+}
+
+void BoxTable::Builder::noteFrame(int frameIndex)
+{
+    if (m_lastFrame < m_firstFrame) {
+        m_firstFrame = m_lastFrame = frameIndex;
+    } else {
+        if (frameIndex < m_lastFrame)
+            m_sorted = false;
+        m_firstFrame = std::min(m_firstFrame, frameIndex);
+        m_lastFrame = std::max(m_lastFrame, frameIndex);
+    }
+}
+
+void BoxTable::Builder::addFrame(int frameIndex, const std::vector<BoundingBox>& boxes)
+{
+    noteFrame(frameIndex);
+    for (const auto& box : boxes) {
+        m_storage.frame.push_back(frameIndex);
+        m_storage.trackId.push_back(box.trackId);
+        m_storage.labelId.push_back(box.labelId);
+        m_storage.x.push_back(static_cast<float>(box.rect.x()));
+        m_storage.y.push_back(static_cast<float>(box.rect.y()));
+        m_storage.width.push_back(static_cast<float>(box.rect.width()));
+        m_storage.height.push_back(static_cast<float>(box.rect.height()));
+        m_storage.confidence.push_back(static_cast<float>(box.confidence));
+    }
+}
+
+void BoxTable::Builder::addBox(int frameIndex, int trackId, int labelId, float x, float y,
+                               float width, float height, float confidence)
+{
+    noteFrame(frameIndex);
+    m_storage.frame.push_back(frameIndex);
+    m_storage.trackId.push_back(trackId);
+    m_storage.labelId.push_back(labelId);
+    m_storage.x.push_back(x);
+    m_storage.y.push_back(y);
+    m_storage.width.push_back(width);
+    m_storage.height.push_back(height);
+    m_storage.confidence.push_back(confidence);
+}
+
+BoxTable BoxTable::Builder::build()
+{
+    auto storage = std::make_shared<Storage>(std::move(m_storage));
+    Storage& s = *storage;
+    const int rows = static_cast<int>(s.frame.size());
+
+    // Out-of-order frames (e.g. both tracking directions interleaved) are
+    // put in frame order once, keeping the order within a frame
+    if (!m_sorted) {
+        std::vector<int> order(rows);
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(),
+                         [&s](int a, int b) { return s.frame[a] < s.frame[b]; });
+        permute(s.frame, order);
+        permute(s.trackId, order);
+        permute(s.labelId, order);
+        permute(s.x, order);
+        permute(s.y, order);
+        permute(s.width, order);
+        permute(s.height, order);
+        permute(s.confidence, order);
+    }
+
+    if (m_lastFrame >= m_firstFrame) {
+        // Counting pass, then a prefix sum: rows of frame f start at
+        // frameOffsets[f - first]
+        s.frameOffsets.assign(m_lastFrame - m_firstFrame + 2, 0);
+        for (int frame : s.frame)
+            ++s.frameOffsets[frame - m_firstFrame + 1];
+        std::partial_sum(s.frameOffsets.begin(), s.frameOffsets.end(), s.frameOffsets.begin());
+    }
+
+    // Rows are already in frame order, so a stable sort by track keeps each
+    // track's rows in frame order too
+    s.trackOrder.resize(rows);
+    std::iota(s.trackOrder.begin(), s.trackOrder.end(), 0);
+    std::stable_sort(s.trackOrder.begin(), s.trackOrder.end(),
+                     [&s](int a, int b) { return s.trackId[a] < s.trackId[b]; });
+    for (int i = 0; i < rows; ++i) {
+        int track = s.trackId[s.trackOrder[i]];
+        if (s.tracks.empty() || s.tracks.back() != track) {
+            s.tracks.push_back(track);
+            s.trackOffsets.push_back(i);
+        }
+    }
+    s.trackOffsets.push_back(rows);
+
+    BoxTable table;
+    Arrays& a = table.m_arrays;
+    a.columns.frame = view(s.frame);
+    a.columns.trackId = view(s.trackId);
+    a.columns.labelId = view(s.labelId);
+    a.columns.x = view(s.x);
+    a.columns.y = view(s.y);
+    a.columns.width = view(s.width);
+    a.columns.height = view(s.height);
+    a.columns.confidence = view(s.confidence);
+    a.frameOffsets = view(s.frameOffsets);
+    a.tracks = view(s.tracks);
+    a.trackOffsets = view(s.trackOffsets);
+    a.trackOrder = view(s.trackOrder);
+    a.firstFrame = m_firstFrame;
+    a.lastFrame = m_lastFrame;
+    table.m_owner = std::move(storage);
+
+    *this = Builder();
+    return table;
+}
+
+bool BoxTable::wrap(std::shared_ptr<const void> owner, const Arrays& arrays, BoxTable& table)
+{
+    // Only the index arrays are checked; the columns are read on demand
+    const Columns& c = arrays.columns;
+    const int rows = c.frame.size();
+    if (c.trackId.size() != rows || c.labelId.size() != rows || c.x.size() != rows ||
+        c.y.size() != rows || c.width.size() != rows || c.height.size() != rows ||
+        c.confidence.size() != rows)
+        return false;
+
+    if (arrays.lastFrame < arrays.firstFrame) {
+        if (rows != 0 || !arrays.frameOffsets.empty())
+            return false;
+    } else {
+        long long frames = static_cast<long long>(arrays.lastFrame) - arrays.firstFrame + 1;
+        if (arrays.frameOffsets.size() != frames + 1 || !isOffsetTable(arrays.frameOffsets, rows))
+            return false;
+    }
+
+    if (arrays.trackOffsets.size() != arrays.tracks.size() + 1 ||
+        !isOffsetTable(arrays.trackOffsets, rows) ||
+        std::adjacent_find(arrays.tracks.begin(), arrays.tracks.end(),
+                           std::greater_equal<int>()) != arrays.tracks.end())
+        return false;
+    if (arrays.trackOrder.size() != rows ||
+        std::any_of(arrays.trackOrder.begin(), arrays.trackOrder.end(),
+                    [rows](int row) { return row < 0 || row >= rows; }))
+        return false;
+
+    table.m_owner = std::move(owner);
+    table.m_arrays = arrays;
+    return true;
+}
+
+BoxTable BoxTable::fromAnnotations(const std::vector<FrameAnnotationPtr>& annotations)
+{
+    Builder builder;
+    size_t rows = 0;
+    for (const auto& fa : annotations)
+        rows += fa->boxes.size();
+    builder.reserve(rows);
+    for (const auto& fa : annotations)
+        builder.addFrame(fa->frameIndex, fa->boxes);
+    return builder.build();
+}
+
+BoxTable BoxTable::detached() const
+{
+    Builder builder;
+    const Columns& c = m_arrays.columns;
+    builder.reserve(rowCount());
+    for (int row = 0; row < rowCount(); ++row)
+        builder.addBox(c.frame[row], c.trackId[row], c.labelId[row], c.x[row], c.y[row],
+                       c.width[row], c.height[row], c.confidence[row]);
+    // Frames without boxes at either end still belong to the range
+    builder.m_firstFrame = firstFrame();
+    builder.m_lastFrame = lastFrame();
+    return builder.build();
+}
+
+std::vector<FrameAnnotation> BoxTable::toAnnotations() const
+{
+    std::vector<FrameAnnotation> annotations;
+    if (empty())
+        return annotations;
+    annotations.reserve(lastFrame() - firstFrame() + 1);
+    for (int frame = firstFrame(); frame <= lastFrame(); ++frame) {
+        FrameAnnotation fa;
+        fa.frameIndex = frame;
+        fa.boxes = boxesAt(frame);
+        annotations.push_back(std::move(fa));
+    }
+    return annotations;
+}
+
+BoxTable::Rows BoxTable::frameRows(int frame) const
+{
+    Rows rows;
+    if (!containsFrame(frame))
+        return rows;
+    rows.begin = m_arrays.frameOffsets[frame - firstFrame()];
+    rows.end = m_arrays.frameOffsets[frame - firstFrame() + 1];
+    return rows;
+}
+
+std::vector<BoundingBox> BoxTable::boxesAt(int frame) const
+{
+    Rows rows = frameRows(frame);
+    std::vector<BoundingBox> boxes;
+    boxes.reserve(rows.size());
+    for (int row = rows.begin; row < rows.end; ++row)
+        boxes.push_back(box(row));
+    return boxes;
+}
+
+BoundingBox BoxTable::box(int row) const
+{
+    BoundingBox box;
+    const Columns& c = m_arrays.columns;
+    box.trackId = c.trackId[row];
+    box.labelId = c.labelId[row];
+    box.rect = QRectF(c.x[row], c.y[row], c.width[row], c.height[row]);
+    box.confidence = c.confidence[row];
+    return box;
+}
+
+BoxTable::Rows BoxTable::trackRows(int trackId) const
+{
+    Rows rows;
+    const Column<int>& tracks = m_arrays.tracks;
+    auto it = std::lower_bound(tracks.begin(), tracks.end(), trackId);
+    if (it == tracks.end() || *it != trackId)
+        return rows;
+    int i = static_cast<int>(it - tracks.begin());
+    rows.begin = m_arrays.trackOffsets[i];
+    rows.end = m_arrays.trackOffsets[i + 1];
+    return rows;
+}
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+struct BoundingBox;
+struct FrameAnnotation;
+
+// Immutable column store of the boxes of a frame range: one array per field
+// instead of one object per box. Rows are ordered by frame. A per-frame
+// offset table finds a frame's rows in O(1), and a per-track offset table
+// over a track-ordered row list finds a track's rows in frame order.
+// Coordinates are floats, which is plenty for pixel positions and halves
+// their footprint compared with QRectF.
+//
+// A table only views its arrays. They belong to a shared owner, either the
+// builder's vectors or a memory-mapped project file, so copying a table is
+// cheap and a loaded one only reads the pages it is asked about.
+class BoxTable {
+public:
+    // Read-only view of one array, valid while the table's owner lives
+    template <typename T>
+    class Column {
+    public:
+        Column() = default;
+        Column(const T* data, int size) : m_data(data), m_size(size) {}
+
+        const T& operator[](int i) const { return m_data[i]; }
+        const T* data() const { return m_data; }
+        const T* begin() const { return m_data; }
+        const T* end() const { return m_data + m_size; }
+        int      size() const { return m_size; }
+        bool     empty() const { return m_size == 0; }
+
+    private:
+        const T* m_data = nullptr;
+        int      m_size = 0;
+    };
+
+    struct Columns {
+        Column<int>   frame;
+        Column<int>   trackId;
+        Column<int>   labelId;
+        Column<float> x;
+        Column<float> y;
+        Column<float> width;
+        Column<float> height;
+        Column<float> confidence;
+    };
+
+    // Every array of a table, as written to and mapped from a project file
+    struct Arrays {
+        Columns     columns;
+        Column<int> frameOffsets; // lastFrame - firstFrame + 2 entries
+        Column<int> tracks;
+        Column<int> trackOffsets; // tracks.size() + 1 entries
+        Column<int> trackOrder;   // row indices grouped by track
+        int         firstFrame = 0;
+        int         lastFrame = -1;
+    };
+
+    // Half-open index range
+    struct Rows {
+        int begin = 0;
+        int end = 0;
+        bool empty() const { return begin == end; }
+        int  size() const { return end - begin; }
+    };
+
+    // Collects boxes frame by frame. Frames may arrive in any order; boxes
+    // added for the same frame are appended to each other.
+    class Builder {
+    public:
+        void     reserve(size_t rows);
+        void     addFrame(int frameIndex, const std::vector<BoundingBox>& boxes);
+        void     addBox(int frameIndex, int trackId, int labelId, float x, float y,
+                        float width, float height, float confidence);
+        BoxTable build();
+
+    private:
+        friend class BoxTable;
+
+        struct Storage {
+            std::vector<int>   frame;
+            std::vector<int>   trackId;
+            std::vector<int>   labelId;
+            std::vector<float> x;
+            std::vector<float> y;
+            std::vector<float> width;
+            std::vector<float> height;
+            std::vector<float> confidence;
+            std::vector<int>   frameOffsets;
+            std::vector<int>   tracks;
+            std::vector<int>   trackOffsets;
+            std::vector<int>   trackOrder;
+        };
+
+        void noteFrame(int frameIndex);
+
+        Storage m_storage;
+        int     m_firstFrame = 0;
+        int     m_lastFrame = -1;
+        bool    m_sorted = true;
+    };
+
+    static BoxTable fromAnnotations(const std::vector<std::shared_ptr<const FrameAnnotation>>& annotations);
+    std::vector<FrameAnnotation> toAnnotations() const;
+
+    // Views arrays kept alive by owner. Returns false, leaving table as it
+    // was, if the index arrays do not fit each other and the columns.
+    static bool wrap(std::shared_ptr<const void> owner, const Arrays& arrays, BoxTable& table);
+    const Arrays& arrays() const { return m_arrays; }
+
+    // Copy that owns its arrays, e.g. to let go of a mapped file
+    BoxTable detached() const;
+
+    bool empty() const { return m_arrays.lastFrame < m_arrays.firstFrame; }
+    int  rowCount() const { return m_arrays.columns.frame.size(); }
+
+    // Every frame in [firstFrame, lastFrame] belongs to the table, with or
+    // without boxes
+    int  firstFrame() const { return m_arrays.firstFrame; }
+    int  lastFrame() const { return m_arrays.lastFrame; }
+    bool containsFrame(int frame) const { return frame >= firstFrame() && frame <= lastFrame(); }
+
+    Rows frameRows(int frame) const;
+    std::vector<BoundingBox> boxesAt(int frame) const;
+    BoundingBox box(int row) const;
+
+    // Distinct track ids, ascending
+    Column<int> tracks() const { return m_arrays.tracks; }
+    // Positions in trackOrder() holding the rows of trackId, in frame order
+    Rows trackRows(int trackId) const;
+    Column<int> trackOrder() const { return m_arrays.trackOrder; }
+
+    const Columns& columns() const { return m_arrays.columns; }
+
+private:
+    std::shared_ptr<const void> m_owner;
+    Arrays                      m_arrays;
+};
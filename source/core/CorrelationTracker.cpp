@@ -0,0 +1,315 @@
+#include "CorrelationTracker.h"
+#include <opencv2/core/hal/intrin.hpp>
+#include <opencv2/core/utility.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+// Keeps the filter finite on frequencies the target has no energy at
+static constexpr float kEpsilon = 1e-5f;
+
+// Peak neighbourhood left out of the sidelobe statistics
+static constexpr int kPeakExclusion = 11;
+
+// Small rotations and scalings of the first frame, so a new filter is not
+// the exact inverse of a single patch
+struct Perturbation {
+    float angle; // radians
+    float scale;
+};
+static constexpr Perturbation kInitSamples[] = {
+    {0.0f, 1.0f}, {-0.1f, 1.0f}, {0.1f, 1.0f}, {0.0f, 0.95f}, {0.0f, 1.05f},
+};
+
+// num = keep * num + rate * G conj(F), den = keep * den + rate * |F|^2.
+// G and F are interleaved complex spectra; num is split into planes.
+static void blendFilter(const float* g, const float* f, float* numRe, float* numIm,
+                        float* den, int n, float keep, float rate)
+{
+    int k = 0;
+#if CV_SIMD128
+    const cv::v_float32x4 vKeep = cv::v_setall_f32(keep);
+    const cv::v_float32x4 vRate = cv::v_setall_f32(rate);
+    for (; k <= n - 4; k += 4) {
+        cv::v_float32x4 gr, gi, fr, fi;
+        cv::v_load_deinterleave(g + 2 * k, gr, gi);
+        cv::v_load_deinterleave(f + 2 * k, fr, fi);
+        cv::v_float32x4 re = cv::v_muladd(gi, fi, gr * fr);
+        cv::v_float32x4 im = gi * fr - gr * fi;
+        cv::v_float32x4 power = cv::v_muladd(fi, fi, fr * fr);
+        cv::v_store(numRe + k, cv::v_muladd(cv::v_load(numRe + k), vKeep, re * vRate));
+        cv::v_store(numIm + k, cv::v_muladd(cv::v_load(numIm + k), vKeep, im * vRate));
+        cv::v_store(den + k, cv::v_muladd(cv::v_load(den + k), vKeep, power * vRate));
+    }
+#endif
+    for (; k < n; ++k) {
+        float gr = g[2 * k], gi = g[2 * k + 1];
+        float fr = f[2 * k], fi = f[2 * k + 1];
+        numRe[k] = keep * numRe[k] + rate * (gr * fr + gi * fi);
+        numIm[k] = keep * numIm[k] + rate * (gi * fr - gr * fi);
+        den[k]   = keep * den[k]   + rate * (fr * fr + fi * fi);
+    }
+}
+
+// out = F * num / den, interleaved like F
+static void applyFilter(const float* f, const float* numRe, const float* numIm,
+                        const float* den, float* out, int n)
+{
+    int k = 0;
+#if CV_SIMD128
+    const cv::v_float32x4 vEpsilon = cv::v_setall_f32(kEpsilon);
+    for (; k <= n - 4; k += 4) {
+        cv::v_float32x4 fr, fi;
+        cv::v_load_deinterleave(f + 2 * k, fr, fi);
+        cv::v_float32x4 nr = cv::v_load(numRe + k);
+        cv::v_float32x4 ni = cv::v_load(numIm + k);
+        cv::v_float32x4 d = cv::v_load(den + k) + vEpsilon;
+        cv::v_float32x4 re = (fr * nr - fi * ni) / d;
+        cv::v_float32x4 im = cv::v_muladd(fi, nr, fr * ni) / d;
+        cv::v_store_interleave(out + 2 * k, re, im);
+    }
+#endif
+    for (; k < n; ++k) {
+        float fr = f[2 * k], fi = f[2 * k + 1];
+        float d = den[k] + kEpsilon;
+        out[2 * k]     = (fr * numRe[k] - fi * numIm[k]) / d;
+        out[2 * k + 1] = (fr * numIm[k] + fi * numRe[k]) / d;
+    }
+}
+
+CorrelationTracker::CorrelationTracker(const Params& params)
+    : m_params(params)
+{
+    for (int b = 0; b < kBanks; ++b) {
+        Bank& bank = m_banks[b];
+        bank.size = kTemplateSizes[b];
+        cv::createHanningWindow(bank.window, cv::Size(bank.size, bank.size), CV_32F);
+
+        // Gaussian peak on the template center, where a centered target
+        // should correlate
+        cv::Mat desired(bank.size, bank.size, CV_32F);
+        const float c = bank.size * 0.5f;
+        const float denom = 2.0f * m_params.sigma * m_params.sigma;
+        for (int y = 0; y < bank.size; ++y)
+            for (int x = 0; x < bank.size; ++x)
+                desired.at<float>(y, x) =
+                    std::exp(-((x - c) * (x - c) + (y - c) * (y - c)) / denom);
+        cv::dft(desired, bank.response, cv::DFT_COMPLEX_OUTPUT);
+    }
+}
+
+int CorrelationTracker::add(const cv::Mat& gray, const cv::Rect& box)
+{
+    m_targets.emplace_back();
+    int id = static_cast<int>(m_targets.size()) - 1;
+    reset(id, gray, box);
+    return id;
+}
+
+void CorrelationTracker::reset(int id, const cv::Mat& gray, const cv::Rect& box)
+{
+    Target& target = m_targets[id];
+    release(target);
+    place(target, box);
+    train(target, gray);
+}
+
+void CorrelationTracker::clear()
+{
+    m_targets.clear();
+    for (auto& bank : m_banks) {
+        bank.numRe.clear();
+        bank.numIm.clear();
+        bank.den.clear();
+        bank.freeSlots.clear();
+        bank.slots = 0;
+    }
+}
+
+cv::Rect CorrelationTracker::box(int id) const
+{
+    const Target& target = m_targets[id];
+    return cv::Rect(cvRound(target.center.x - target.size.width * 0.5f),
+                    cvRound(target.center.y - target.size.height * 0.5f),
+                    target.size.width, target.size.height);
+}
+
+void CorrelationTracker::update(const cv::Mat& gray)
+{
+    std::vector<int> ids(m_targets.size());
+    std::iota(ids.begin(), ids.end(), 0);
+    update(gray, ids);
+}
+
+void CorrelationTracker::update(const cv::Mat& gray, const std::vector<int>& ids)
+{
+    // Targets only write their own slots, so they run in parallel; the
+    // banks' planes are not resized while an update is in progress
+    cv::parallel_for_(cv::Range(0, static_cast<int>(ids.size())), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; ++i)
+            track(m_targets[ids[i]], gray);
+    });
+}
+
+CorrelationTracker::Scratch& CorrelationTracker::scratch(int bank)
+{
+    thread_local Scratch buffers[kBanks];
+    return buffers[bank];
+}
+
+void CorrelationTracker::place(Target& target, const cv::Rect& box)
+{
+    target.size = cv::Size(std::max(1, box.width), std::max(1, box.height));
+    target.center = cv::Point2f(box.x + target.size.width * 0.5f,
+                                box.y + target.size.height * 0.5f);
+    target.window = cv::Size2f(target.size.width * m_params.padding,
+                               target.size.height * m_params.padding);
+    target.found = true;
+
+    // Smallest template that keeps the window at full detail; larger
+    // windows are downsampled into the biggest one
+    float side = std::max(target.window.width, target.window.height);
+    target.bank = kBanks - 1;
+    for (int b = 0; b < kBanks; ++b) {
+        if (side <= kTemplateSizes[b]) {
+            target.bank = b;
+            break;
+        }
+    }
+
+    Bank& bank = m_banks[target.bank];
+    if (!bank.freeSlots.empty()) {
+        target.slot = bank.freeSlots.back();
+        bank.freeSlots.pop_back();
+    } else {
+        target.slot = bank.slots++;
+        size_t values = static_cast<size_t>(bank.slots) * bank.size * bank.size;
+        bank.numRe.resize(values);
+        bank.numIm.resize(values);
+        bank.den.resize(values);
+    }
+}
+
+void CorrelationTracker::release(Target& target)
+{
+    if (target.bank >= 0)
+        m_banks[target.bank].freeSlots.push_back(target.slot);
+    target.bank = -1;
+    target.slot = -1;
+}
+
+void CorrelationTracker::train(Target& target, const cv::Mat& gray)
+{
+    Bank& bank = m_banks[target.bank];
+    const int n = bank.size * bank.size;
+    const size_t offset = static_cast<size_t>(target.slot) * n;
+    float* numRe = bank.numRe.data() + offset;
+    float* numIm = bank.numIm.data() + offset;
+    float* den = bank.den.data() + offset;
+    std::fill(numRe, numRe + n, 0.0f);
+    std::fill(numIm, numIm + n, 0.0f);
+    std::fill(den, den + n, 0.0f);
+
+    Scratch& s = scratch(target.bank);
+    for (const auto& sample : kInitSamples) {
+        spectrum(target, gray, sample.angle, sample.scale, s);
+        blendFilter(bank.response.ptr<float>(), s.spectrum.ptr<float>(),
+                    numRe, numIm, den, n, 1.0f, 1.0f);
+    }
+}
+
+void CorrelationTracker::track(Target& target, const cv::Mat& gray)
+{
+    Bank& bank = m_banks[target.bank];
+    const int size = bank.size;
+    const int n = size * size;
+    const size_t offset = static_cast<size_t>(target.slot) * n;
+    float* numRe = bank.numRe.data() + offset;
+    float* numIm = bank.numIm.data() + offset;
+    float* den = bank.den.data() + offset;
+    Scratch& s = scratch(target.bank);
+
+    spectrum(target, gray, 0.0f, 1.0f, s);
+    s.product.create(size, size, CV_32FC2);
+    applyFilter(s.spectrum.ptr<float>(), numRe, numIm, den, s.product.ptr<float>(), n);
+    cv::dft(s.product, s.correlation, cv::DFT_INVERSE | cv::DFT_SCALE | cv::DFT_REAL_OUTPUT);
+
+    double peak = 0.0;
+    cv::Point at;
+    cv::minMaxLoc(s.correlation, nullptr, &peak, nullptr, &at);
+
+    // Peak-to-sidelobe ratio: how far the peak stands out of the rest
+    s.mask.create(size, size, CV_8U);
+    s.mask.setTo(255);
+    cv::rectangle(s.mask, cv::Rect(at.x - kPeakExclusion / 2, at.y - kPeakExclusion / 2,
+                                   kPeakExclusion, kPeakExclusion),
+                  cv::Scalar(0), cv::FILLED);
+    cv::Scalar mean, stddev;
+    cv::meanStdDev(s.correlation, mean, stddev, s.mask);
+    double psr = (peak - mean[0]) / (stddev[0] + kEpsilon);
+    target.found = psr >= m_params.psrThreshold;
+    if (!target.found)
+        return;
+
+    target.center.x += (at.x - size * 0.5f) * target.window.width / size;
+    target.center.y += (at.y - size * 0.5f) * target.window.height / size;
+
+    spectrum(target, gray, 0.0f, 1.0f, s);
+    blendFilter(bank.response.ptr<float>(), s.spectrum.ptr<float>(), numRe, numIm, den, n,
+                1.0f - m_params.learningRate, m_params.learningRate);
+}
+
+void CorrelationTracker::spectrum(const Target& target, const cv::Mat& gray,
+                                  float angle, float scale, Scratch& s) const
+{
+    const Bank& bank = m_banks[target.bank];
+    const float half = bank.size * 0.5f;
+
+    // Template pixel (u, v) samples the image at center + A (u - half, v - half),
+    // with A stretching the template over the window and applying the perturbation
+    float sx = target.window.width / bank.size * scale;
+    float sy = target.window.height / bank.size * scale;
+    float cs = std::cos(angle), sn = std::sin(angle);
+    cv::Matx23f map(cs * sx, -sn * sy, 0.0f,
+                    sn * sx,  cs * sy, 0.0f);
+    map(0, 2) = target.center.x - (map(0, 0) + map(0, 1)) * half;
+    map(1, 2) = target.center.y - (map(1, 0) + map(1, 1)) * half;
+    cv::warpAffine(gray, s.pixels, map, cv::Size(bank.size, bank.size),
+                   cv::INTER_LINEAR | cv::WARP_INVERSE_MAP, cv::BORDER_REPLICATE);
+
+    // Log intensities, normalized and tapered towards the template border
+    s.pixels.convertTo(s.patch, CV_32F, 1.0, 1.0);
+    cv::log(s.patch, s.patch);
+    cv::Scalar mean, stddev;
+    cv::meanStdDev(s.patch, mean, stddev);
+    double norm = 1.0 / (stddev[0] + kEpsilon);
+    s.patch.convertTo(s.patch, CV_32F, norm, -mean[0] * norm);
+    cv::multiply(s.patch, bank.window, s.patch);
+    cv::dft(s.patch, s.spectrum, cv::DFT_COMPLEX_OUTPUT);
+}
+
+cv::Mat CorrelationTrackerAdapter::toGray(cv::InputArray image)
+{
+    cv::Mat mat = image.getMat();
+    if (mat.channels() == 1)
+        return mat;
+    cv::Mat gray;
+    cv::cvtColor(mat, gray, mat.channels() == 4 ? cv::COLOR_BGRA2GRAY : cv::COLOR_BGR2GRAY);
+    return gray;
+}
+
+void CorrelationTrackerAdapter::init(cv::InputArray image, const cv::Rect& boundingBox)
+{
+    m_tracker.clear();
+    m_id = m_tracker.add(toGray(image), boundingBox);
+}
+
+bool CorrelationTrackerAdapter::update(cv::InputArray image, cv::Rect& boundingBox)
+{
+    if (m_id < 0)
+        return false;
+    m_tracker.update(toGray(image));
+    boundingBox = m_tracker.box(m_id);
+    return m_tracker.found(m_id);
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <opencv2/tracking.hpp>
+#include <vector>
+
+// MOSSE correlation filters for many targets, all moved by one update() call
+// per grayscale frame. Each target's search window is resampled to one of a
+// few fixed template sizes. Targets of one size form a bank: they share the
+// cosine window, the spectrum of the desired response and the FFT scratch
+// buffers, and their filters sit slot after slot in split real/imaginary
+// planes that the per-frequency kernels stream through with SIMD loads.
+class CorrelationTracker {
+public:
+    struct Params {
+        float learningRate = 0.125f;
+        float sigma        = 2.0f;  // of the desired response, in template pixels
+        float padding      = 1.5f;  // search window size relative to the box
+        float psrThreshold = 6.0f;  // peak-to-sidelobe ratio below which a target is lost
+    };
+
+    explicit CorrelationTracker(const Params& params = Params());
+
+    // Starts a target on its first frame and returns its id
+    int  add(const cv::Mat& gray, const cv::Rect& box);
+    // Restarts a target on a new box, keeping its id
+    void reset(int id, const cv::Mat& gray, const cv::Rect& box);
+    void clear();
+    bool empty() const { return m_targets.empty(); }
+
+    // Moves every target, or only the given ones, to the next frame. Lost
+    // targets keep their last box and are not trained on the frame.
+    void update(const cv::Mat& gray);
+    void update(const cv::Mat& gray, const std::vector<int>& ids);
+
+    cv::Rect box(int id) const;
+    bool     found(int id) const { return m_targets[id].found; }
+
+private:
+    struct Target {
+        cv::Point2f center;
+        cv::Size    size;        // of the box; MOSSE does not adapt scale
+        cv::Size2f  window;      // search window in image pixels
+        int         bank = -1;
+        int         slot = -1;
+        bool        found = true;
+    };
+
+    struct Bank {
+        int                size = 0;  // template side, a fast DFT size
+        cv::Mat            window;    // cosine window, CV_32F
+        cv::Mat            response;  // spectrum of the desired response, CV_32FC2
+        std::vector<float> numRe;     // filter numerators and denominators,
+        std::vector<float> numIm;     // size * size values per slot
+        std::vector<float> den;
+        std::vector<int>   freeSlots;
+        int                slots = 0;
+    };
+
+    // Per-thread buffers reused across targets and frames
+    struct Scratch {
+        cv::Mat pixels, patch, spectrum, product, correlation, mask;
+    };
+
+    static constexpr int kBanks = 3;
+    static constexpr int kTemplateSizes[kBanks] = {32, 64, 128};
+
+    static Scratch& scratch(int bank);
+    void  place(Target& target, const cv::Rect& box);
+    void  release(Target& target);
+    void  train(Target& target, const cv::Mat& gray);
+    void  track(Target& target, const cv::Mat& gray);
+    void  spectrum(const Target& target, const cv::Mat& gray, float angle, float scale,
+                   Scratch& s) const;
+
+    Params              m_params;
+    Bank                m_banks[kBanks];
+    std::vector<Target> m_targets;
+};
+
+// Single-target cv::Tracker front end, for code that drives trackers one by
+// one rather than in a batch
+class CorrelationTrackerAdapter : public cv::Tracker {
+public:
+    void init(cv::InputArray image, const cv::Rect& boundingBox) override;
+    bool update(cv::InputArray image, cv::Rect& boundingBox) override;
+
+private:
+    static cv::Mat toGray(cv::InputArray image);
+
+    CorrelationTracker m_tracker;
+    int                m_id = -1;
+};
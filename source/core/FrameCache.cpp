@@ -0,0 +1,128 @@
+#include "FrameCache.h"
+#include <QMutexLocker>
+#include <cstdlib>
+#include <iterator>
+
+static size_t frameBytes(const cv::Mat& frame)
+{
+    return frame.total() * frame.elemSize();
+}
+
+FrameCache::FrameCache(size_t budgetBytes)
+    : m_budget(budgetBytes)
+{
+}
+
+void FrameCache::setBudget(size_t bytes)
+{
+    QMutexLocker lock(&m_mutex);
+    m_budget = bytes;
+    evictToBudget();
+}
+
+size_t FrameCache::budget() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_budget;
+}
+
+bool FrameCache::lookup(int index, cv::Mat& frame)
+{
+    QMutexLocker lock(&m_mutex);
+    auto it = m_entries.find(index);
+    if (it == m_entries.end()) {
+        ++m_misses;
+        return false;
+    }
+
+    m_lru.splice(m_lru.begin(), m_lru, it->second);
+    frame = it->second->second;
+    ++m_hits;
+    return true;
+}
+
+bool FrameCache::contains(int index) const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_entries.count(index) != 0;
+}
+
+bool FrameCache::nearest(int index, int maxDistance, int& foundIndex,
+                         cv::Mat& frame) const
+{
+    QMutexLocker lock(&m_mutex);
+    auto after = m_entries.lower_bound(index);
+    auto best = m_entries.end();
+    if (after != m_entries.end())
+        best = after;
+    if (after != m_entries.begin()) {
+        auto before = std::prev(after);
+        if (best == m_entries.end() || index - before->first < best->first - index)
+            best = before;
+    }
+    if (best == m_entries.end() || std::abs(best->first - index) > maxDistance)
+        return false;
+
+    foundIndex = best->first;
+    frame = best->second->second;
+    return true;
+}
+
+void FrameCache::insert(int index, const cv::Mat& frame)
+{
+    if (frame.empty())
+        return;
+
+    QMutexLocker lock(&m_mutex);
+    if (frameBytes(frame) > m_budget)
+        return;
+
+    auto it = m_entries.find(index);
+    if (it != m_entries.end()) {
+        m_bytes -= frameBytes(it->second->second);
+        it->second->second = frame;
+        m_lru.splice(m_lru.begin(), m_lru, it->second);
+    } else {
+        m_lru.emplace_front(index, frame);
+        m_entries[index] = m_lru.begin();
+    }
+    m_bytes += frameBytes(frame);
+    evictToBudget();
+}
+
+void FrameCache::clear()
+{
+    QMutexLocker lock(&m_mutex);
+    m_lru.clear();
+    m_entries.clear();
+    m_bytes = 0;
+}
+
+FrameCache::Stats FrameCache::stats() const
+{
+    QMutexLocker lock(&m_mutex);
+    Stats s;
+    s.hits = m_hits;
+    s.misses = m_misses;
+    s.bytes = m_bytes;
+    s.budget = m_budget;
+    s.frames = static_cast<int>(m_entries.size());
+    return s;
+}
+
+void FrameCache::resetStats()
+{
+    QMutexLocker lock(&m_mutex);
+    m_hits = 0;
+    m_misses = 0;
+}
+
+void FrameCache::evictToBudget()
+{
+    while (m_bytes > m_budget && !m_lru.empty()) {
+        const Entry& victim = m_lru.back();
+        m_bytes -= frameBytes(victim.second);
+        m_entries.erase(victim.first);
+        m_lru.pop_back();
+    }
+}
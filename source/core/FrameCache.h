@@ -0,0 +1,52 @@
+#pragma once
+
+#include <QMutex>
+#include <opencv2/core.hpp>
+#include <cstddef>
+#include <list>
+#include <map>
+#include <utility>
+
+// LRU cache of decoded frames keyed by frame index and bounded by a byte
+// budget. Cached Mats are shared, so callers must clone before drawing on them.
+class FrameCache {
+public:
+    struct Stats {
+        unsigned long long hits = 0;
+        unsigned long long misses = 0;
+        size_t             bytes = 0;
+        size_t             budget = 0;
+        int                frames = 0;
+    };
+
+    static constexpr size_t kDefaultBudget = size_t(1) << 30; // 1 GiB
+
+    explicit FrameCache(size_t budgetBytes = kDefaultBudget);
+
+    void   setBudget(size_t bytes);
+    size_t budget() const;
+
+    // Counts a hit or a miss
+    bool lookup(int index, cv::Mat& frame);
+    bool contains(int index) const;
+    // Closest cached frame within maxDistance of index; not counted in stats
+    bool nearest(int index, int maxDistance, int& foundIndex, cv::Mat& frame) const;
+    void insert(int index, const cv::Mat& frame);
+    void clear();
+
+    Stats stats() const;
+    void  resetStats();
+
+private:
+    using Entry = std::pair<int, cv::Mat>;
+
+    void evictToBudget();
+
+    mutable QMutex                                         m_mutex;
+    std::list<Entry>                                       m_lru; // front = most recent
+    std::map<int, std::list<Entry>::iterator>              m_entries; // ordered for nearest()
+    size_t                                                 m_bytes = 0;
+    size_t                                                 m_budget;
+    unsigned long long                                     m_hits = 0;
+    unsigned long long                                     m_misses = 0;
+};
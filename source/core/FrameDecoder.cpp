@@ -0,0 +1,335 @@
+#include "FrameDecoder.h"
+#include <QMutexLocker>
+#include <QThread>
+#include <algorithm>
+
+FrameDecoder::FrameDecoder(int capacity)
+    : m_capacity(std::max(1, capacity))
+{
+}
+
+FrameDecoder::~FrameDecoder()
+{
+    close();
+}
+
+bool FrameDecoder::open(const QString& path)
+{
+    close();
+
+    if (!m_capture.open(path.toStdString()))
+        return false;
+
+    m_totalFrames = static_cast<int>(m_capture.get(cv::CAP_PROP_FRAME_COUNT));
+    m_fps = m_capture.get(cv::CAP_PROP_FPS);
+    if (m_fps <= 0) m_fps = 30.0;
+
+    int w = static_cast<int>(m_capture.get(cv::CAP_PROP_FRAME_WIDTH));
+    int h = static_cast<int>(m_capture.get(cv::CAP_PROP_FRAME_HEIGHT));
+    m_frameSize = QSize(w, h);
+
+    m_buffer.clear();
+    m_nextIndex = 0;
+    m_endIndex = m_totalFrames;
+    m_seekTarget = -1;
+    m_targetGrabbed = false;
+    m_stride = 1;
+    m_strideOrigin = 0;
+    m_stopping = false;
+    m_opened = true;
+
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->start();
+    return true;
+}
+
+void FrameDecoder::close()
+{
+    if (m_thread) {
+        {
+            QMutexLocker lock(&m_mutex);
+            m_stopping = true;
+            m_spaceAvailable.wakeAll();
+        }
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+
+    if (m_capture.isOpened())
+        m_capture.release();
+
+    m_buffer.clear();
+    m_keyframes.reset();
+    m_asyncTarget = -1;
+    m_asyncCallback = nullptr;
+    m_opened = false;
+    m_totalFrames = 0;
+    m_frameSize = QSize();
+}
+
+void FrameDecoder::setKeyframeIndex(std::shared_ptr<const KeyframeIndex> index)
+{
+    QMutexLocker lock(&m_mutex);
+    m_keyframes = std::move(index);
+}
+
+cv::Mat FrameDecoder::frameAt(int index)
+{
+    QMutexLocker lock(&m_mutex);
+    if (!m_opened || index < 0 || index >= m_totalFrames)
+        return cv::Mat();
+
+    // A blocking request takes over the read position from any async one
+    m_asyncTarget = -1;
+    m_asyncCallback = nullptr;
+    m_blockingTarget = index;
+    positionFor(index);
+
+    cv::Mat frame;
+    for (;;) {
+        if (!m_buffer.empty() && m_buffer.front().index == index) {
+            frame = m_buffer.front().mat;
+            break;
+        }
+        if (m_seekTarget < 0 && index >= m_endIndex)
+            break;
+        m_frameReady.wait(&m_mutex);
+        dropBefore(index);
+
+        // Grabbed past without decoding before the request was seen
+        if (!m_buffer.empty() && m_buffer.front().index > index)
+            requestSeek(index);
+    }
+    m_blockingTarget = -1;
+    return frame;
+}
+
+void FrameDecoder::requestFrame(int index, FrameCallback onReady)
+{
+    QMutexLocker lock(&m_mutex);
+    if (!m_opened || index < 0 || index >= m_totalFrames)
+        return;
+
+    // Replaces any pending request; a seek already under way for the old
+    // target is abandoned by the worker between grabs
+    positionFor(index);
+    if (!m_buffer.empty() && m_buffer.front().index == index) {
+        m_asyncTarget = -1;
+        m_asyncCallback = nullptr;
+        cv::Mat frame = m_buffer.front().mat;
+        lock.unlock();
+        onReady(index, frame);
+        return;
+    }
+    m_asyncTarget = index;
+    m_asyncCallback = std::move(onReady);
+}
+
+void FrameDecoder::setStride(int stride, int origin)
+{
+    QMutexLocker lock(&m_mutex);
+    m_stride = std::max(1, stride);
+    m_strideOrigin = origin;
+
+    // Frames off the new grid are no longer wanted
+    m_buffer.erase(std::remove_if(m_buffer.begin(), m_buffer.end(),
+                                  [this](const DecodedFrame& f) { return !wanted(f.index); }),
+                   m_buffer.end());
+
+    // Grid frames the worker has already passed must still be buffered;
+    // the first one that was only grabbed is decoded again from a seek
+    for (int i = origin + 1; i < m_nextIndex; ++i) {
+        if (!wanted(i))
+            continue;
+        bool buffered = std::any_of(m_buffer.begin(), m_buffer.end(),
+                                    [i](const DecodedFrame& f) { return f.index == i; });
+        if (!buffered) {
+            requestSeek(i);
+            break;
+        }
+    }
+    m_spaceAvailable.wakeAll();
+}
+
+StageStats FrameDecoder::stats() const
+{
+    QMutexLocker lock(&m_mutex);
+    StageStats stats;
+    stats.processed = m_decoded;
+    stats.depth = static_cast<int>(m_buffer.size());
+    stats.capacity = m_capacity;
+    return stats;
+}
+
+bool FrameDecoder::wanted(int index) const
+{
+    if (m_stride == 1 || index == m_blockingTarget || index == m_asyncTarget)
+        return true;
+    int offset = index - m_strideOrigin;
+    return offset >= 0 && offset % m_stride == 0;
+}
+
+void FrameDecoder::positionFor(int index)
+{
+    dropBefore(index);
+
+    // Anything behind the read position, or too far ahead of it, needs a
+    // seek. Within the GOP being decoded, reading through is never slower.
+    bool behind = !m_buffer.empty() ? m_buffer.front().index > index
+                                    : index < m_nextIndex;
+    bool farAhead = index > m_nextIndex + kMaxReadThrough;
+    if (farAhead && m_keyframes) {
+        int key = m_keyframes->keyframeAtOrBefore(index);
+        farAhead = key < 0 || key > m_nextIndex;
+    }
+    if (behind || farAhead)
+        requestSeek(index);
+}
+
+void FrameDecoder::dropBefore(int index)
+{
+    bool dropped = false;
+    while (!m_buffer.empty() && m_buffer.front().index < index) {
+        m_buffer.pop_front();
+        dropped = true;
+    }
+    if (dropped)
+        m_spaceAvailable.wakeAll();
+}
+
+void FrameDecoder::requestSeek(int index)
+{
+    m_buffer.clear();
+    m_nextIndex = index;
+    m_endIndex = m_totalFrames;
+    m_seekTarget = index;
+    m_targetGrabbed = false;
+    ++m_generation;
+    m_spaceAvailable.wakeAll();
+}
+
+void FrameDecoder::run()
+{
+    QMutexLocker lock(&m_mutex);
+    while (!m_stopping) {
+        if (m_seekTarget >= 0) {
+            int      target = m_seekTarget;
+            unsigned generation = m_generation;
+            auto     keyframes = m_keyframes;
+            m_seekTarget = -1;
+            lock.unlock();
+            bool grabbed = seekTo(target, keyframes.get(), generation);
+            lock.relock();
+            m_targetGrabbed = grabbed && generation == m_generation;
+            continue;
+        }
+
+        if (static_cast<int>(m_buffer.size()) >= m_capacity ||
+            m_nextIndex >= m_endIndex) {
+            m_spaceAvailable.wait(&m_mutex);
+            continue;
+        }
+
+        // Frames short of a pending async target are only grabbed: buffering
+        // them could fill the buffer before the target is reached
+        int      index = m_nextIndex;
+        unsigned generation = m_generation;
+        bool     decode = wanted(index) && (m_asyncTarget < 0 || index >= m_asyncTarget);
+        bool     grabbed = m_targetGrabbed;
+        m_targetGrabbed = false;
+        lock.unlock();
+        cv::Mat frame;
+        bool ok;
+        if (grabbed)
+            ok = !decode || m_capture.retrieve(frame);
+        else
+            ok = decode ? m_capture.read(frame) : m_capture.grab();
+        lock.relock();
+
+        // A seek arrived while reading: the frame belongs to the old position
+        if (generation != m_generation)
+            continue;
+
+        if (ok) {
+            if (decode) {
+                m_buffer.push_back({index, frame});
+                ++m_decoded;
+            }
+            m_nextIndex = index + 1;
+        } else {
+            m_endIndex = index;
+        }
+        m_frameReady.wakeAll();
+
+        if (m_asyncTarget >= 0 && ((index == m_asyncTarget && decode) || !ok)) {
+            FrameCallback callback = std::move(m_asyncCallback);
+            m_asyncCallback = nullptr;
+            m_asyncTarget = -1;
+            if (ok && callback) {
+                lock.unlock();
+                callback(index, frame);
+                lock.relock();
+            }
+        }
+    }
+}
+
+bool FrameDecoder::seekTo(int target, const KeyframeIndex* keyframes,
+                          unsigned generation)
+{
+    KeyframeIndex::Keyframe key;
+    if (!keyframes || !keyframes->keyframeAtOrBefore(target, key)) {
+        m_capture.set(cv::CAP_PROP_POS_FRAMES, target);
+        return false;
+    }
+
+    if (!grabKeyframe(key, keyframes, generation)) {
+        if (generation == m_generation)
+            m_capture.set(cv::CAP_PROP_POS_FRAMES, target);
+        return false;
+    }
+
+    // On the keyframe for certain; grab() then decodes up to the target
+    // without converting the skipped frames
+    for (int i = key.frame; i < target; ++i) {
+        if (generation != m_generation)
+            return false; // superseded, the worker loop handles the newer seek
+        if (!m_capture.grab())
+            return false;
+    }
+    return true;
+}
+
+bool FrameDecoder::grabKeyframe(const KeyframeIndex::Keyframe& key,
+                                const KeyframeIndex* keyframes, unsigned generation)
+{
+    // OpenCV turns every seek, CAP_PROP_POS_MSEC included, into a timestamp
+    // guessed from the frame number, which is off in variable frame rate
+    // video. The pts of the grabbed frames shows where it really landed. A
+    // landing short of the keyframe reads on up to it; one past it starts
+    // over from an earlier keyframe. The start of the stream needs no pts.
+    if (key.frame == 0) {
+        m_capture.set(cv::CAP_PROP_POS_FRAMES, 0);
+        return generation == m_generation && m_capture.grab();
+    }
+
+    int from = key.frame;
+    for (int attempt = 0; attempt < kMaxSeekAttempts; ++attempt) {
+        m_capture.set(cv::CAP_PROP_POS_FRAMES, from);
+        for (;;) {
+            if (generation != m_generation || !m_capture.grab())
+                return false;
+            long long pts = static_cast<long long>(m_capture.get(cv::CAP_PROP_PTS));
+            if (pts == key.pts)
+                return true;
+            if (pts > key.pts)
+                break;
+        }
+        if (from == 0)
+            return false;
+        KeyframeIndex::Keyframe earlier;
+        from = keyframes->keyframeAtOrBefore(from - 1, earlier) ? earlier.frame : 0;
+    }
+    return false;
+}
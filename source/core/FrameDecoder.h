@@ -0,0 +1,104 @@
+#pragma once
+
+#include <QMutex>
+#include <QSize>
+#include <QString>
+#include <QWaitCondition>
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include "KeyframeIndex.h"
+#include "StageStats.h"
+
+class QThread;
+
+// Owns a cv::VideoCapture that is read on a worker thread. The worker decodes
+// ahead of the consumer into a bounded ring buffer, so sequential frameAt()
+// calls are served without waiting on the codec.
+class FrameDecoder {
+public:
+    explicit FrameDecoder(int capacity = 8);
+    ~FrameDecoder();
+
+    FrameDecoder(const FrameDecoder&) = delete;
+    FrameDecoder& operator=(const FrameDecoder&) = delete;
+
+    bool open(const QString& path);
+    void close();
+    bool isOpened() const { return m_opened; }
+
+    // Once set, seeks land on the preceding keyframe, found by its pts, and
+    // decode forward
+    void setKeyframeIndex(std::shared_ptr<const KeyframeIndex> index);
+
+    int    totalFrames() const { return m_totalFrames; }
+    double fps() const { return m_fps; }
+    QSize  frameSize() const { return m_frameSize; }
+
+    // Blocks until the frame is decoded. Returns an empty Mat past the end
+    // of the stream or on a read error.
+    cv::Mat frameAt(int index);
+
+    // Latest-wins asynchronous request: supersedes any pending one, and
+    // onReady runs on the worker thread once the frame is decoded. Frames
+    // passed on the way to the target are grabbed, not decoded or buffered.
+    using FrameCallback = std::function<void(int index, const cv::Mat& frame)>;
+    void requestFrame(int index, FrameCallback onReady);
+
+    // Read-ahead only decodes origin + k * stride; the frames in between are
+    // grabbed without decoding. frameAt() still returns any frame, but one
+    // off the grid costs a seek once the read position has passed it.
+    void setStride(int stride, int origin);
+
+    // Decoded frames so far and read-ahead buffer fill
+    StageStats stats() const;
+
+private:
+    struct DecodedFrame {
+        int     index = 0;
+        cv::Mat mat;
+    };
+
+    void run();
+    void positionFor(int index);
+    void dropBefore(int index);
+    void requestSeek(int index);
+    bool seekTo(int target, const KeyframeIndex* keyframes, unsigned generation);
+    bool grabKeyframe(const KeyframeIndex::Keyframe& key, const KeyframeIndex* keyframes,
+                      unsigned generation);
+    bool wanted(int index) const;
+
+    // Frames further ahead than this are reached by seeking, not reading through
+    static constexpr int kMaxReadThrough = 32;
+    // Seeks that keep landing past their keyframe fall back after this many
+    static constexpr int kMaxSeekAttempts = 3;
+
+    cv::VideoCapture         m_capture;   // only touched by the worker once open
+    QThread*                 m_thread = nullptr;
+    mutable QMutex           m_mutex;
+    QWaitCondition           m_frameReady;     // worker -> consumer
+    QWaitCondition           m_spaceAvailable; // consumer -> worker
+    std::deque<DecodedFrame> m_buffer;
+    int                      m_capacity;
+    int                      m_nextIndex = 0;   // next index the worker reads
+    int                      m_endIndex = 0;    // first index that failed to read
+    int                      m_seekTarget = -1; // pending seek, -1 = none
+    bool                     m_targetGrabbed = false; // seek grabbed m_nextIndex already
+    std::atomic<unsigned>    m_generation{0};   // bumped on every seek
+    std::shared_ptr<const KeyframeIndex> m_keyframes;
+    int                      m_asyncTarget = -1;
+    FrameCallback            m_asyncCallback;
+    int                      m_blockingTarget = -1; // frameAt() in progress
+    int                      m_stride = 1;
+    int                      m_strideOrigin = 0;
+    bool                     m_stopping = false;
+    unsigned long long       m_decoded = 0;
+
+    bool    m_opened = false;
+    int     m_totalFrames = 0;
+    double  m_fps = 30.0;
+    QSize   m_frameSize;
+};
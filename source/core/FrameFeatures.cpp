@@ -0,0 +1,54 @@
+#include "FrameFeatures.h"
+#include <opencv2/imgproc.hpp>
+
+void FrameFeatures::require(int level, TrackerInput input)
+{
+    m_required[level][static_cast<int>(input)] = true;
+}
+
+void FrameFeatures::clearRequirements()
+{
+    for (auto& level : m_required)
+        for (bool& required : level)
+            required = false;
+}
+
+void FrameFeatures::build(const cv::Mat& frame)
+{
+    const int color = static_cast<int>(TrackerInput::Color);
+    const int gray = static_cast<int>(TrackerInput::Gray);
+
+    // The colour chain runs as deep as any requirement: each level halves
+    // the previous one, and gray levels are converted from the colour level
+    // of the same size rather than downscaled separately
+    int deepest = -1;
+    for (int level = 0; level < kLevels; ++level)
+        if (m_required[level][color] || m_required[level][gray])
+            deepest = level;
+
+    for (int level = 0; level < kLevels; ++level) {
+        m_images[level][color] = cv::Mat();
+        m_images[level][gray] = cv::Mat();
+        if (level > deepest || frame.empty())
+            continue;
+
+        if (level == 0)
+            m_images[level][color] = frame;
+        else
+            cv::resize(m_images[level - 1][color], m_images[level][color], cv::Size(),
+                       0.5, 0.5, cv::INTER_AREA);
+
+        if (m_required[level][gray]) {
+            const cv::Mat& source = m_images[level][color];
+            if (source.channels() == 1)
+                m_images[level][gray] = source;
+            else
+                cv::cvtColor(source, m_images[level][gray], cv::COLOR_BGR2GRAY);
+        }
+    }
+}
+
+const cv::Mat& FrameFeatures::image(int level, TrackerInput input) const
+{
+    return m_images[level][static_cast<int>(input)];
+}
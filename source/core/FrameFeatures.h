@@ -0,0 +1,29 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include "TrackerFactory.h"
+
+// Per-frame preprocessing shared by every tracker updating on the frame:
+// the downscaled pyramid and its grayscale versions. A representation is
+// built once per frame, and only if some tracker requires it, instead of
+// once per tracker inside update().
+class FrameFeatures {
+public:
+    // Full, half and quarter resolution
+    static constexpr int kLevels = 3;
+
+    void require(int level, TrackerInput input);
+    void clearRequirements();
+
+    // Drops the previous frame's representations and builds the required ones
+    void build(const cv::Mat& frame);
+
+    // Empty unless required before build()
+    const cv::Mat& image(int level, TrackerInput input) const;
+
+private:
+    static constexpr int kInputs = 2;
+
+    bool    m_required[kLevels][kInputs] = {};
+    cv::Mat m_images[kLevels][kInputs];
+};
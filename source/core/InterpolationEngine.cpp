@@ -0,0 +1,208 @@
+#include "InterpolationEngine.h"
+#include <algorithm>
+
+namespace {
+
+// One keyframe of one track
+struct Sample {
+    int         frame = 0;
+    BoundingBox box;
+};
+
+// Box components interpolated independently
+constexpr int kComponents = 4;
+
+void components(const QRectF& rect, double out[kComponents])
+{
+    out[0] = rect.x();
+    out[1] = rect.y();
+    out[2] = rect.width();
+    out[3] = rect.height();
+}
+
+// Second derivatives of a natural cubic spline through (t[i], y[i]), solved
+// with the tridiagonal (Thomas) algorithm
+std::vector<double> splineMoments(const std::vector<double>& t, const std::vector<double>& y)
+{
+    const size_t n = t.size();
+    std::vector<double> m(n, 0.0);
+    if (n < 3)
+        return m;
+
+    std::vector<double> c(n, 0.0), d(n, 0.0);
+    for (size_t i = 1; i + 1 < n; ++i) {
+        double h0 = t[i] - t[i - 1];
+        double h1 = t[i + 1] - t[i];
+        double a = h0 / 6.0;
+        double b = (h0 + h1) / 3.0;
+        double cc = h1 / 6.0;
+        double r = (y[i + 1] - y[i]) / h1 - (y[i] - y[i - 1]) / h0;
+        double denom = b - a * c[i - 1];
+        c[i] = cc / denom;
+        d[i] = (r - a * d[i - 1]) / denom;
+    }
+    for (size_t i = n - 2; i >= 1; --i)
+        m[i] = d[i] - c[i] * m[i + 1];
+    return m;
+}
+
+double splineAt(const std::vector<double>& t, const std::vector<double>& y,
+                const std::vector<double>& m, size_t seg, double x)
+{
+    double h = t[seg + 1] - t[seg];
+    double a = (t[seg + 1] - x) / h;
+    double b = (x - t[seg]) / h;
+    return a * y[seg] + b * y[seg + 1] +
+           ((a * a * a - a) * m[seg] + (b * b * b - b) * m[seg + 1]) * h * h / 6.0;
+}
+
+// Least-squares fit y = intercept + slope * t
+void fitLine(const std::vector<double>& t, const std::vector<double>& y,
+             double& intercept, double& slope)
+{
+    const double n = static_cast<double>(t.size());
+    double st = 0, sy = 0, stt = 0, sty = 0;
+    for (size_t i = 0; i < t.size(); ++i) {
+        st += t[i];
+        sy += y[i];
+        stt += t[i] * t[i];
+        sty += t[i] * y[i];
+    }
+    double denom = n * stt - st * st;
+    slope = denom != 0.0 ? (n * sty - st * sy) / denom : 0.0;
+    intercept = (sy - slope * st) / n;
+}
+
+// Appends the track's box to every frame of its span in out, which starts
+// at frame `first`
+void fillTrack(const std::vector<Sample>& samples, InterpolationModel model,
+               int first, std::vector<FrameAnnotation>& out)
+{
+    const size_t n = samples.size();
+    std::vector<double> t(n);
+    std::vector<double> y[kComponents];
+    for (auto& v : y)
+        v.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        double c[kComponents];
+        components(samples[i].box.rect, c);
+        t[i] = samples[i].frame;
+        for (int k = 0; k < kComponents; ++k)
+            y[k][i] = c[k];
+    }
+
+    std::vector<double> moments[kComponents];
+    double intercept[kComponents] = {}, slope[kComponents] = {};
+    if (model == InterpolationModel::CubicSpline) {
+        for (int k = 0; k < kComponents; ++k)
+            moments[k] = splineMoments(t, y[k]);
+    } else if (model == InterpolationModel::ConstantVelocity) {
+        for (int k = 0; k < kComponents; ++k)
+            fitLine(t, y[k], intercept[k], slope[k]);
+    }
+
+    size_t seg = 0;
+    for (int frame = samples.front().frame; frame <= samples.back().frame; ++frame) {
+        while (seg + 2 < n && frame > samples[seg + 1].frame)
+            ++seg;
+
+        // Identity comes from the preceding keyframe, confidence is blended
+        const Sample& s0 = samples[seg];
+        const Sample& s1 = samples[std::min(seg + 1, n - 1)];
+        double span = s1.frame - s0.frame;
+        double u = span > 0 ? (frame - s0.frame) / span : 0.0;
+
+        double c[kComponents];
+        for (int k = 0; k < kComponents; ++k) {
+            switch (model) {
+            case InterpolationModel::CubicSpline:
+                c[k] = n > 1 ? splineAt(t, y[k], moments[k], seg, frame) : y[k][0];
+                break;
+            case InterpolationModel::ConstantVelocity:
+                c[k] = intercept[k] + slope[k] * frame;
+                break;
+            case InterpolationModel::Linear:
+            default:
+                c[k] = y[k][seg] + (y[k][std::min(seg + 1, n - 1)] - y[k][seg]) * u;
+                break;
+            }
+        }
+
+        BoundingBox box = s0.box;
+        box.rect = QRectF(c[0], c[1], std::max(1.0, c[2]), std::max(1.0, c[3]));
+        box.confidence = s0.box.confidence + (s1.box.confidence - s0.box.confidence) * u;
+        out[frame - first].boxes.push_back(box);
+    }
+}
+
+} // namespace
+
+InterpolationEngine::InterpolationEngine(QObject* parent)
+    : QObject(parent)
+{
+}
+
+void InterpolationEngine::setKeyframe(const FrameAnnotation& keyframe)
+{
+    m_keyframes[keyframe.frameIndex] = keyframe;
+    emit keyframesChanged();
+}
+
+void InterpolationEngine::removeKeyframe(int frameIndex)
+{
+    if (m_keyframes.erase(frameIndex))
+        emit keyframesChanged();
+}
+
+void InterpolationEngine::clear()
+{
+    if (m_keyframes.empty())
+        return;
+    m_keyframes.clear();
+    emit keyframesChanged();
+}
+
+std::vector<FrameAnnotation> InterpolationEngine::interpolate() const
+{
+    return interpolate(m_keyframes, m_model);
+}
+
+std::vector<FrameAnnotation> InterpolationEngine::interpolate(
+    const std::map<int, FrameAnnotation>& keyframes, InterpolationModel model)
+{
+    if (keyframes.empty())
+        return {};
+
+    // Keyframes are already in frame order, so each track's samples are too
+    std::map<int, std::vector<Sample>> tracks;
+    for (const auto& entry : keyframes) {
+        for (const auto& box : entry.second.boxes) {
+            Sample s;
+            s.frame = entry.first;
+            s.box = box;
+            tracks[box.trackId].push_back(s);
+        }
+    }
+
+    int first = keyframes.begin()->first;
+    int last = keyframes.rbegin()->first;
+    std::vector<FrameAnnotation> out(static_cast<size_t>(last - first + 1));
+    for (int frame = first; frame <= last; ++frame) {
+        out[frame - first].frameIndex = frame;
+        out[frame - first].boxes.reserve(tracks.size());
+    }
+
+    for (const auto& track : tracks)
+        fillTrack(track.second, model, first, out);
+    return out;
+}
+
+QString InterpolationEngine::modelName(InterpolationModel model)
+{
+    switch (model) {
+    case InterpolationModel::Linear:           return tr("Linear");
+    case InterpolationModel::CubicSpline:      return tr("Cubic Spline");
+    case InterpolationModel::ConstantVelocity: return tr("Constant Velocity");
+    }
+    return QString();
+}
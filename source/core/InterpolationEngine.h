@@ -0,0 +1,48 @@
+#pragma once
+
+#include <QObject>
+#include <map>
+#include <vector>
+#include "AnnotationData.h"
+
+enum class InterpolationModel {
+    Linear,           // straight line between neighbouring keyframes
+    CubicSpline,      // natural cubic spline through all keyframes of a track
+    ConstantVelocity  // least-squares straight-line motion over all keyframes
+};
+
+// Alternative to TrackingEngine for smooth motion: boxes are placed on sparse
+// keyframes and every frame in between is computed, without decoding any
+// video. Boxes are matched across keyframes by trackId; each track is filled
+// from its first to its last keyframe.
+class InterpolationEngine : public QObject {
+    Q_OBJECT
+public:
+    explicit InterpolationEngine(QObject* parent = nullptr);
+
+    void setModel(InterpolationModel model) { m_model = model; }
+    InterpolationModel model() const { return m_model; }
+
+    // Replaces any keyframe already set on the same frame
+    void setKeyframe(const FrameAnnotation& keyframe);
+    void removeKeyframe(int frameIndex);
+    void clear();
+
+    const std::map<int, FrameAnnotation>& keyframes() const { return m_keyframes; }
+    bool isEmpty() const { return m_keyframes.empty(); }
+
+    // One annotation per frame from the first to the last keyframe, in frame
+    // order, ready for AnnotationData::setActiveAnnotations()
+    std::vector<FrameAnnotation> interpolate() const;
+
+    static std::vector<FrameAnnotation> interpolate(const std::map<int, FrameAnnotation>& keyframes,
+                                                    InterpolationModel model);
+    static QString modelName(InterpolationModel model);
+
+signals:
+    void keyframesChanged();
+
+private:
+    std::map<int, FrameAnnotation> m_keyframes; // by frame index
+    InterpolationModel             m_model = InterpolationModel::Linear;
+};
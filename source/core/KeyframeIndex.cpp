@@ -0,0 +1,171 @@
+#include "KeyframeIndex.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QThread>
+#include <opencv2/videoio.hpp>
+#include <algorithm>
+
+static constexpr quint32 kSidecarMagic   = 0x47544b49; // "GTKI"
+static constexpr quint32 kSidecarVersion = 1;
+
+KeyframeIndex::~KeyframeIndex()
+{
+    cancel();
+}
+
+void KeyframeIndex::loadOrBuild(const QString& videoPath, int totalFrames)
+{
+    cancel();
+    m_cancelled = false;
+    {
+        QMutexLocker lock(&m_mutex);
+        m_keyframes.clear();
+        m_ready = false;
+    }
+
+    if (load(videoPath, totalFrames))
+        return;
+
+    m_thread = QThread::create([this, videoPath, totalFrames]() {
+        build(videoPath, totalFrames);
+    });
+    m_thread->start(QThread::LowPriority);
+}
+
+void KeyframeIndex::cancel()
+{
+    m_cancelled = true;
+    if (m_thread) {
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+}
+
+bool KeyframeIndex::isReady() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_ready;
+}
+
+int KeyframeIndex::keyframeAtOrBefore(int frame) const
+{
+    Keyframe keyframe;
+    return keyframeAtOrBefore(frame, keyframe) ? keyframe.frame : -1;
+}
+
+bool KeyframeIndex::keyframeAtOrBefore(int frame, Keyframe& keyframe) const
+{
+    QMutexLocker lock(&m_mutex);
+    if (!m_ready || m_keyframes.empty())
+        return false;
+
+    auto it = std::upper_bound(m_keyframes.begin(), m_keyframes.end(), frame,
+                               [](int f, const Keyframe& k) { return f < k.frame; });
+    if (it == m_keyframes.begin())
+        return false;
+    keyframe = *std::prev(it);
+    return true;
+}
+
+QString KeyframeIndex::sidecarPath(const QString& videoPath)
+{
+    return videoPath + ".gtidx";
+}
+
+bool KeyframeIndex::load(const QString& videoPath, int totalFrames)
+{
+    QFile file(sidecarPath(videoPath));
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QFileInfo info(videoPath);
+    QDataStream in(&file);
+    quint32 magic = 0, version = 0;
+    qint64  size = 0, modified = 0;
+    qint32  frames = 0, count = 0;
+    in >> magic >> version >> size >> modified >> frames >> count;
+
+    // A stale sidecar (video replaced or re-encoded) is rebuilt
+    if (in.status() != QDataStream::Ok || magic != kSidecarMagic ||
+        version != kSidecarVersion || size != info.size() ||
+        modified != info.lastModified().toMSecsSinceEpoch() ||
+        frames != totalFrames || count <= 0)
+        return false;
+
+    std::vector<Keyframe> keyframes(static_cast<size_t>(count));
+    for (auto& k : keyframes) {
+        qint32 frame = 0;
+        qint64 pts = 0;
+        in >> frame >> pts;
+        k.frame = frame;
+        k.pts = pts;
+    }
+    if (in.status() != QDataStream::Ok)
+        return false;
+
+    QMutexLocker lock(&m_mutex);
+    m_keyframes = std::move(keyframes);
+    m_ready = true;
+    return true;
+}
+
+bool KeyframeIndex::save(const QString& videoPath, int totalFrames) const
+{
+    QSaveFile file(sidecarPath(videoPath));
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    QFileInfo info(videoPath);
+    QDataStream out(&file);
+    QMutexLocker lock(&m_mutex);
+    out << kSidecarMagic << kSidecarVersion
+        << static_cast<qint64>(info.size())
+        << static_cast<qint64>(info.lastModified().toMSecsSinceEpoch())
+        << static_cast<qint32>(totalFrames)
+        << static_cast<qint32>(m_keyframes.size());
+    for (const auto& k : m_keyframes)
+        out << static_cast<qint32>(k.frame) << static_cast<qint64>(k.pts);
+    lock.unlock();
+
+    return file.commit();
+}
+
+void KeyframeIndex::build(const QString& videoPath, int totalFrames)
+{
+    // Raw mode hands back undecoded packets, so the scan costs only demuxing
+    cv::VideoCapture capture;
+    if (!capture.open(videoPath.toStdString(), cv::CAP_FFMPEG,
+                      {cv::CAP_PROP_FORMAT, -1}))
+        return;
+
+    std::vector<Keyframe> keyframes;
+    int frame = 0;
+    while (!m_cancelled && capture.grab()) {
+        if (capture.get(cv::CAP_PROP_LRF_HAS_KEY_FRAME) != 0) {
+            Keyframe k;
+            k.frame = frame;
+            k.pts = static_cast<long long>(capture.get(cv::CAP_PROP_PTS));
+            keyframes.push_back(k);
+        }
+        ++frame;
+    }
+    capture.release();
+
+    // Backends without keyframe flags leave the index unused
+    if (m_cancelled || keyframes.empty())
+        return;
+    if (keyframes.front().frame != 0)
+        keyframes.insert(keyframes.begin(), Keyframe{0, 0});
+
+    {
+        QMutexLocker lock(&m_mutex);
+        m_keyframes = std::move(keyframes);
+        m_ready = true;
+    }
+    save(videoPath, totalFrames);
+}
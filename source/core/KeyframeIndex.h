@@ -0,0 +1,50 @@
+#pragma once
+
+#include <QMutex>
+#include <QString>
+#include <atomic>
+#include <vector>
+
+class QThread;
+
+// Keyframe positions of a video, used to turn random seeks into
+// "seek to the preceding keyframe, decode forward". The index is built on a
+// background thread by scanning packets without decoding them and persisted
+// in a sidecar file next to the video, so reopening the video is instant.
+class KeyframeIndex {
+public:
+    struct Keyframe {
+        int       frame = 0;
+        long long pts = 0;
+    };
+
+    KeyframeIndex() = default;
+    ~KeyframeIndex();
+
+    KeyframeIndex(const KeyframeIndex&) = delete;
+    KeyframeIndex& operator=(const KeyframeIndex&) = delete;
+
+    // Loads the sidecar if it matches the video, otherwise starts a
+    // background scan that writes it when done.
+    void loadOrBuild(const QString& videoPath, int totalFrames);
+    void cancel();
+
+    bool isReady() const;
+
+    // Nearest keyframe at or before frame, or -1 while the index is not ready
+    int keyframeAtOrBefore(int frame) const;
+    bool keyframeAtOrBefore(int frame, Keyframe& keyframe) const;
+
+    static QString sidecarPath(const QString& videoPath);
+
+private:
+    bool load(const QString& videoPath, int totalFrames);
+    bool save(const QString& videoPath, int totalFrames) const;
+    void build(const QString& videoPath, int totalFrames);
+
+    mutable QMutex        m_mutex;
+    std::vector<Keyframe> m_keyframes; // sorted by frame
+    bool                  m_ready = false;
+    std::atomic<bool>     m_cancelled{false};
+    QThread*              m_thread = nullptr;
+};
@@ -17,20 +17,25 @@ bool MotExporter::exportToFile(const QString& filePath,
     int globalFrame = 1;
 
     for (const auto& seg : segments) {
-        for (const auto& fa : seg.annotations) {
-            for (const auto& box : fa.boxes) {
+        // Rows are stored in frame order, so each segment is one pass over
+        // its columns
+        const BoxTable& table = seg.boxes;
+        const BoxTable::Columns& c = table.columns();
+        for (int frame = table.firstFrame(); frame <= table.lastFrame(); ++frame) {
+            BoxTable::Rows rows = table.frameRows(frame);
+            for (int row = rows.begin; row < rows.end; ++row) {
                 // Find class id from label
-                int classId = box.labelId;
-                double visibility = (box.confidence > 0) ? 1.0 : 0.0;
+                int classId = c.labelId[row];
+                double visibility = (c.confidence[row] > 0) ? 1.0 : 0.0;
 
                 // MOT format: frame,id,bb_left,bb_top,bb_width,bb_height,conf,class,visibility
                 out << globalFrame << ","
-                    << box.trackId << ","
-                    << static_cast<int>(box.rect.x()) << ","
-                    << static_cast<int>(box.rect.y()) << ","
-                    << static_cast<int>(box.rect.width()) << ","
-                    << static_cast<int>(box.rect.height()) << ","
-                    << box.confidence << ","
+                    << c.trackId[row] << ","
+                    << static_cast<int>(c.x[row]) << ","
+                    << static_cast<int>(c.y[row]) << ","
+                    << static_cast<int>(c.width[row]) << ","
+                    << static_cast<int>(c.height[row]) << ","
+                    << c.confidence[row] << ","
                     << classId << ","
                     << visibility << "\n";
             }
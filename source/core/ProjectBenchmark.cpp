@@ -0,0 +1,134 @@
+#include "ProjectBenchmark.h"
+#include "AnnotationData.h"
+#include "MotExporter.h"
+#include "ProjectFile.h"
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+// Reads frame,id,x,y,w,h,conf,class,... lines into one table
+static BoxTable parseMot(const QString& path)
+{
+    BoxTable::Builder builder;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return builder.build();
+    while (!file.atEnd()) {
+        QList<QByteArray> fields = file.readLine().trimmed().split(',');
+        if (fields.size() < 8)
+            continue;
+        builder.addBox(fields[0].toInt(), fields[1].toInt(), fields[7].toInt(),
+                       fields[2].toFloat(), fields[3].toFloat(), fields[4].toFloat(),
+                       fields[5].toFloat(), fields[6].toFloat());
+    }
+    return builder.build();
+}
+
+// Sum over every box, so each column page is actually read
+static double touchAll(const std::vector<ResultSegment>& segments)
+{
+    double sum = 0.0;
+    for (const auto& seg : segments) {
+        const BoxTable::Columns& c = seg.boxes.columns();
+        for (int row = 0; row < seg.boxes.rowCount(); ++row)
+            sum += c.x[row] + c.y[row] + c.width[row] + c.height[row] + c.confidence[row];
+    }
+    return sum;
+}
+
+// Best time of kRuns calls, in milliseconds
+static double bestOf(int runs, const std::function<void()>& work)
+{
+    double best = std::numeric_limits<double>::max();
+    for (int i = 0; i < runs; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        work();
+        best = std::min(best, timer.nsecsElapsed() / 1e6);
+    }
+    return best;
+}
+
+static bool writeSyntheticProject(const QString& path)
+{
+    BoxTable::Builder builder;
+    builder.reserve(static_cast<size_t>(ProjectBenchmark::kFrames) * ProjectBenchmark::kBoxesPerFrame);
+    for (int frame = 0; frame < ProjectBenchmark::kFrames; ++frame) {
+        for (int box = 0; box < ProjectBenchmark::kBoxesPerFrame; ++box) {
+            float x = static_cast<float>(100 * box + frame % 500);
+            builder.addBox(frame, box + 1, 1, x, 120.0f, 64.0f, 48.0f, 1.0f);
+        }
+    }
+
+    AnnotationData data;
+    LabelDef label;
+    label.id = data.nextLabelId();
+    label.name = QStringLiteral("object");
+    data.addLabel(label);
+
+    ResultSegment seg;
+    seg.segmentId = data.nextSegmentId();
+    seg.title = QStringLiteral("synthetic");
+    seg.startFrame = 0;
+    seg.endFrame = ProjectBenchmark::kFrames - 1;
+    seg.boxes = builder.build();
+    data.acceptSegment(std::move(seg));
+    return ProjectFile::save(path, data, QString());
+}
+
+QString ProjectBenchmark::run(const QString& projectPath)
+{
+    QTemporaryDir dir;
+    if (!dir.isValid())
+        return QStringLiteral("Cannot create a temporary directory.\n");
+
+    QString project = projectPath;
+    if (project.isEmpty()) {
+        project = dir.filePath(QStringLiteral("synthetic.") + ProjectFile::suffix());
+        if (!writeSyntheticProject(project))
+            return QStringLiteral("Cannot write %1.\n").arg(project);
+    }
+
+    // The same boxes as MOT text, written by the exporter
+    QString mot = dir.filePath(QStringLiteral("boxes.txt"));
+    int rows = 0;
+    {
+        AnnotationData data;
+        if (!ProjectFile::load(project, data))
+            return QStringLiteral("Cannot load %1.\n").arg(project);
+        for (const auto& seg : data.segments())
+            rows += seg.boxes.rowCount();
+        if (!MotExporter::exportToFile(mot, data.segments(), data.labels()))
+            return QStringLiteral("Cannot write %1.\n").arg(mot);
+    }
+
+    double checksum = 0.0;
+    double open = bestOf(kRuns, [&]() {
+        AnnotationData data;
+        ProjectFile::load(project, data);
+    });
+    double openAndRead = bestOf(kRuns, [&]() {
+        AnnotationData data;
+        ProjectFile::load(project, data);
+        checksum += touchAll(data.segments());
+    });
+    double parse = bestOf(kRuns, [&]() {
+        BoxTable table = parseMot(mot);
+        checksum += table.rowCount();
+    });
+
+    QString report;
+    report += QStringLiteral("Boxes: %1\n").arg(rows);
+    report += QStringLiteral("Project file: %1 KB, MOT text: %2 KB\n")
+                  .arg(QFileInfo(project).size() >> 10).arg(QFileInfo(mot).size() >> 10);
+    report += QStringLiteral("Open project (mapped):        %1 ms\n").arg(open, 0, 'f', 2);
+    report += QStringLiteral("Open project, read all boxes: %1 ms\n").arg(openAndRead, 0, 'f', 2);
+    report += QStringLiteral("Parse MOT text:               %1 ms\n").arg(parse, 0, 'f', 2);
+    report += QStringLiteral("Best of %1 runs, warm page cache (checksum %2)\n")
+                  .arg(kRuns).arg(checksum, 0, 'g', 6);
+    return report;
+}
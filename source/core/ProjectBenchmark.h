@@ -0,0 +1,19 @@
+#pragma once
+
+#include <QString>
+
+// Times opening a project file against parsing the same boxes from MOT
+// text, the only other way to get them back. Runs from the command line
+// (--benchmark-load) and returns a printable report.
+class ProjectBenchmark {
+public:
+    // An empty projectPath benchmarks a synthetic project of kFrames frames
+    static QString run(const QString& projectPath);
+
+    static constexpr int kFrames = 100000;
+    static constexpr int kBoxesPerFrame = 4;
+
+private:
+    // Best of this many runs each, so all of them read from a warm page cache
+    static constexpr int kRuns = 5;
+};
@@ -0,0 +1,263 @@
+#include "ProjectFile.h"
+#include "AnnotationData.h"
+#include <QBuffer>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <type_traits>
+
+static constexpr quint32 kProjectMagic   = 0x4754504a; // "GTPJ"
+static constexpr quint32 kProjectVersion = 1;
+static constexpr quint32 kByteOrderMark  = 0x01020304; // reads back swapped on a foreign CPU
+static constexpr qint64  kArrayAlignment = 64;
+static constexpr qint64  kHeaderSize     = 4 * sizeof(quint32);
+static constexpr qint64  kTrailerSize    = 2 * sizeof(quint64);
+static constexpr quint32 kArrayCount     = 12; // per segment, see visitArrays()
+
+namespace {
+
+// Where one array or image sits in the file
+struct Blob {
+    quint64 offset = 0;
+    qint32  count = 0; // elements, or bytes for an image
+};
+
+// Keeps a loaded project mapped while any table views it
+struct MappedFile {
+    QFile        file;
+    const uchar* data = nullptr;
+    qint64       size = 0;
+
+    ~MappedFile()
+    {
+        if (data)
+            file.unmap(const_cast<uchar*>(data));
+    }
+};
+
+} // namespace
+
+static QDataStream& operator<<(QDataStream& out, const Blob& blob)
+{
+    return out << blob.offset << blob.count;
+}
+
+static QDataStream& operator>>(QDataStream& in, Blob& blob)
+{
+    return in >> blob.offset >> blob.count;
+}
+
+// Calls visit on every array of a table, in file order
+template <typename Arrays, typename Visit>
+static bool visitArrays(Arrays& a, Visit&& visit)
+{
+    return visit(a.columns.frame) && visit(a.columns.trackId) && visit(a.columns.labelId) &&
+           visit(a.columns.x) && visit(a.columns.y) && visit(a.columns.width) &&
+           visit(a.columns.height) && visit(a.columns.confidence) &&
+           visit(a.frameOffsets) && visit(a.tracks) && visit(a.trackOffsets) &&
+           visit(a.trackOrder);
+}
+
+static bool pad(QIODevice& out)
+{
+    qint64 gap = (kArrayAlignment - out.pos() % kArrayAlignment) % kArrayAlignment;
+    return gap == 0 || out.write(QByteArray(static_cast<int>(gap), '\0')) == gap;
+}
+
+// Blob inside [0, end) of the file
+static bool contains(qint64 end, const Blob& blob, size_t elementSize)
+{
+    if (blob.count < 0 || blob.offset > static_cast<quint64>(end))
+        return false;
+    return static_cast<quint64>(blob.count) * elementSize <= static_cast<quint64>(end) - blob.offset;
+}
+
+bool ProjectFile::save(const QString& path, const AnnotationData& data, const QString& videoPath)
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly))
+        return false;
+
+    // Header and trailer are raw, like the arrays, so the byte order mark
+    // tells whether the arrays can be used as they are
+    const quint32 header[4] = { kProjectMagic, kProjectVersion, kByteOrderMark, 0 };
+    if (file.write(reinterpret_cast<const char*>(header), sizeof(header)) != kHeaderSize)
+        return false;
+
+    const auto& segments = data.segments();
+    std::vector<std::vector<Blob>> arrays(segments.size());
+    for (size_t i = 0; i < segments.size(); ++i) {
+        bool ok = visitArrays(segments[i].boxes.arrays(), [&](const auto& column) {
+            using T = std::remove_const_t<std::remove_reference_t<decltype(column[0])>>;
+            if (!pad(file))
+                return false;
+            Blob blob;
+            blob.offset = static_cast<quint64>(file.pos());
+            blob.count = column.size();
+            arrays[i].push_back(blob);
+            qint64 bytes = static_cast<qint64>(column.size()) * static_cast<qint64>(sizeof(T));
+            return bytes == 0 || file.write(reinterpret_cast<const char*>(column.data()), bytes) == bytes;
+        });
+        if (!ok)
+            return false;
+    }
+
+    // Thumbnails after all the arrays, so loading never pages them in
+    // while reading boxes
+    std::vector<Blob> thumbnails(segments.size());
+    for (size_t i = 0; i < segments.size(); ++i) {
+        if (segments[i].thumbnail.isNull())
+            continue;
+        QByteArray png;
+        QBuffer buffer(&png);
+        buffer.open(QIODevice::WriteOnly);
+        segments[i].thumbnail.save(&buffer, "PNG");
+        thumbnails[i].offset = static_cast<quint64>(file.pos());
+        thumbnails[i].count = png.size();
+        if (file.write(png) != png.size())
+            return false;
+    }
+
+    QByteArray meta;
+    QDataStream out(&meta, QIODevice::WriteOnly);
+    AnnotationData::IdCounters counters = data.idCounters();
+    out << videoPath << qint32(counters.nextTrackId) << qint32(counters.nextLabelId)
+        << qint32(counters.nextSegmentId);
+    out << quint32(data.labels().size());
+    for (const auto& label : data.labels())
+        out << qint32(label.id) << label.name << label.description << label.color;
+    out << quint32(segments.size());
+    for (size_t i = 0; i < segments.size(); ++i) {
+        const ResultSegment& seg = segments[i];
+        out << qint32(seg.segmentId) << seg.title << qint32(seg.startFrame)
+            << qint32(seg.endFrame) << qint32(seg.boxes.firstFrame())
+            << qint32(seg.boxes.lastFrame()) << quint32(arrays[i].size());
+        for (const Blob& blob : arrays[i])
+            out << blob;
+        out << thumbnails[i];
+    }
+
+    const quint64 trailer[2] = { static_cast<quint64>(file.pos()),
+                                 static_cast<quint64>(meta.size()) };
+    if (file.write(meta) != meta.size() ||
+        file.write(reinterpret_cast<const char*>(trailer), sizeof(trailer)) != kTrailerSize)
+        return false;
+    return file.commit();
+}
+
+bool ProjectFile::load(const QString& path, AnnotationData& data, QString* videoPath)
+{
+    auto mapped = std::make_shared<MappedFile>();
+    mapped->file.setFileName(path);
+    if (!mapped->file.open(QIODevice::ReadOnly))
+        return false;
+    mapped->size = mapped->file.size();
+    if (mapped->size < kHeaderSize + kTrailerSize)
+        return false;
+    mapped->data = mapped->file.map(0, mapped->size);
+    if (!mapped->data)
+        return false;
+    const uchar* base = mapped->data;
+
+    quint32 header[4];
+    std::memcpy(header, base, sizeof(header));
+    if (header[0] != kProjectMagic || header[1] != kProjectVersion || header[2] != kByteOrderMark)
+        return false;
+
+    quint64 trailer[2];
+    std::memcpy(trailer, base + mapped->size - kTrailerSize, sizeof(trailer));
+    const qint64 metaOffset = static_cast<qint64>(trailer[0]);
+    const quint64 metaSize = trailer[1];
+    if (trailer[0] < static_cast<quint64>(kHeaderSize) ||
+        trailer[0] > static_cast<quint64>(mapped->size - kTrailerSize) ||
+        metaSize > static_cast<quint64>(mapped->size - kTrailerSize - metaOffset) ||
+        metaSize > static_cast<quint64>(std::numeric_limits<int>::max()))
+        return false;
+
+    // Arrays and images all lie before the metadata
+    QByteArray meta = QByteArray::fromRawData(reinterpret_cast<const char*>(base + metaOffset),
+                                              static_cast<int>(metaSize));
+    QDataStream in(meta);
+
+    QString video;
+    qint32 nextTrackId = 0, nextLabelId = 0, nextSegmentId = 0;
+    quint32 labelCount = 0;
+    in >> video >> nextTrackId >> nextLabelId >> nextSegmentId >> labelCount;
+    if (in.status() != QDataStream::Ok || labelCount > metaSize)
+        return false;
+
+    std::vector<LabelDef> labels(labelCount);
+    for (auto& label : labels) {
+        qint32 id = 0;
+        in >> id >> label.name >> label.description >> label.color;
+        label.id = id;
+    }
+
+    quint32 segmentCount = 0;
+    in >> segmentCount;
+    if (in.status() != QDataStream::Ok || segmentCount > metaSize)
+        return false;
+
+    std::vector<ResultSegment> segments(segmentCount);
+    for (auto& seg : segments) {
+        qint32 segmentId = 0, startFrame = 0, endFrame = 0, firstFrame = 0, lastFrame = 0;
+        quint32 arrayCount = 0;
+        in >> segmentId >> seg.title >> startFrame >> endFrame >> firstFrame >> lastFrame
+           >> arrayCount;
+        if (in.status() != QDataStream::Ok || arrayCount != kArrayCount)
+            return false;
+        seg.segmentId = segmentId;
+        seg.startFrame = startFrame;
+        seg.endFrame = endFrame;
+
+        std::vector<Blob> blobs(arrayCount);
+        for (Blob& blob : blobs)
+            in >> blob;
+        Blob thumbnail;
+        in >> thumbnail;
+        if (in.status() != QDataStream::Ok)
+            return false;
+
+        BoxTable::Arrays arrays;
+        arrays.firstFrame = firstFrame;
+        arrays.lastFrame = lastFrame;
+        size_t next = 0;
+        bool ok = visitArrays(arrays, [&](auto& column) {
+            using T = std::remove_const_t<std::remove_reference_t<decltype(column[0])>>;
+            const Blob& blob = blobs[next++];
+            if (!contains(metaOffset, blob, sizeof(T)) || blob.offset % alignof(T) != 0)
+                return false;
+            column = BoxTable::Column<T>(reinterpret_cast<const T*>(base + blob.offset), blob.count);
+            return true;
+        });
+        if (!ok || !BoxTable::wrap(mapped, arrays, seg.boxes))
+            return false;
+
+        if (thumbnail.count > 0) {
+            if (!contains(metaOffset, thumbnail, 1))
+                return false;
+            seg.thumbnail.loadFromData(base + thumbnail.offset, thumbnail.count, "PNG");
+        }
+    }
+
+    // A video moved along with the project is looked for next to it
+    if (!video.isEmpty() && !QFileInfo::exists(video)) {
+        QString sibling = QFileInfo(path).dir().filePath(QFileInfo(video).fileName());
+        if (QFileInfo::exists(sibling))
+            video = sibling;
+    }
+
+    AnnotationData::IdCounters counters;
+    counters.nextTrackId = nextTrackId;
+    counters.nextLabelId = nextLabelId;
+    counters.nextSegmentId = nextSegmentId;
+    data.restore(std::move(labels), std::move(segments), counters);
+    if (videoPath)
+        *videoPath = video;
+    return true;
+}
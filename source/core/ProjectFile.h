@@ -0,0 +1,31 @@
+#pragma once
+
+#include <QString>
+
+class AnnotationData;
+
+// Binary project file (.gtproj): labels, accepted segments, id counters and
+// the path of the video they belong to.
+//
+// Layout, version 1:
+//   header   magic "GTPJ", version, byte order mark, reserved (4 x quint32)
+//   arrays   every BoxTable array of every segment, raw in native byte
+//            order, each starting on a 64-byte boundary
+//   images   segment thumbnails, PNG-compressed
+//   metadata QDataStream: video path, counters, labels, and per segment its
+//            frame range plus the offset and length of each array and image
+//   trailer  metadata offset and size (2 x quint64)
+//
+// Loading maps the file and points the segments' tables straight at their
+// arrays, so only the metadata and the index arrays are read up front and
+// box columns are paged in as frames are looked at. The mapping lives as
+// long as any table viewing it.
+class ProjectFile {
+public:
+    static QString suffix() { return QStringLiteral("gtproj"); }
+
+    static bool save(const QString& path, const AnnotationData& data, const QString& videoPath);
+
+    // On failure data is left as it was
+    static bool load(const QString& path, AnnotationData& data, QString* videoPath = nullptr);
+};
@@ -0,0 +1,52 @@
+#include "ReverseBuffer.h"
+#include "FrameDecoder.h"
+#include "KeyframeIndex.h"
+#include <algorithm>
+
+ReverseBuffer::ReverseBuffer(size_t budgetBytes)
+    : m_budget(budgetBytes)
+{
+}
+
+bool ReverseBuffer::contains(int index) const
+{
+    return index >= m_first &&
+           index < m_first + static_cast<int>(m_frames.size());
+}
+
+cv::Mat ReverseBuffer::frame(int index) const
+{
+    if (!contains(index))
+        return cv::Mat();
+    return m_frames[index - m_first];
+}
+
+void ReverseBuffer::fill(FrameDecoder& decoder, const KeyframeIndex* keyframes,
+                         int index)
+{
+    clear();
+
+    size_t frameBytes = static_cast<size_t>(decoder.frameSize().width()) *
+                        decoder.frameSize().height() * 3;
+    int window = static_cast<int>(std::max<size_t>(1, m_budget / std::max<size_t>(1, frameBytes)));
+
+    int start = std::max(0, index - window + 1);
+    int key = keyframes ? keyframes->keyframeAtOrBefore(index) : -1;
+    if (key >= 0)
+        start = std::max(start, key);
+
+    // The first frameAt() seeks, the rest are sequential reads
+    m_first = start;
+    for (int i = start; i <= index; ++i) {
+        cv::Mat frame = decoder.frameAt(i);
+        if (frame.empty())
+            break;
+        m_frames.push_back(frame);
+    }
+}
+
+void ReverseBuffer::clear()
+{
+    m_frames.clear();
+    m_first = 0;
+}
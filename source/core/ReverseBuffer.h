@@ -0,0 +1,33 @@
+#pragma once
+
+#include <opencv2/core.hpp>
+#include <cstddef>
+#include <deque>
+
+class FrameDecoder;
+class KeyframeIndex;
+
+// Frames preceding a position, decoded in one forward pass from the keyframe
+// so that stepping or playing backwards does not seek once per frame.
+class ReverseBuffer {
+public:
+    static constexpr size_t kDefaultBudget = size_t(512) << 20; // 512 MiB
+
+    explicit ReverseBuffer(size_t budgetBytes = kDefaultBudget);
+
+    void   setBudget(size_t bytes) { m_budget = bytes; }
+    size_t budget() const { return m_budget; }
+
+    bool    contains(int index) const;
+    cv::Mat frame(int index) const;
+
+    // Decodes [start, index] where start is the keyframe before index, or the
+    // earliest frame that still fits the budget
+    void fill(FrameDecoder& decoder, const KeyframeIndex* keyframes, int index);
+    void clear();
+
+private:
+    std::deque<cv::Mat> m_frames;
+    int                 m_first = 0;
+    size_t              m_budget;
+};
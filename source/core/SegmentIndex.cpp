@@ -0,0 +1,89 @@
+#include "SegmentIndex.h"
+#include <algorithm>
+#include <iterator>
+
+void SegmentIndex::split(int frame)
+{
+    // Makes frame the start of a run, inheriting the run it was part of
+    auto it = m_runs.upper_bound(frame);
+    if (it == m_runs.begin()) {
+        m_runs.emplace(frame, std::vector<int>());
+        return;
+    }
+    auto prev = std::prev(it);
+    if (prev->first != frame)
+        m_runs.emplace_hint(it, frame, prev->second);
+}
+
+void SegmentIndex::coalesce(int from, int to)
+{
+    // Neighbouring runs with the same segments become one
+    auto it = m_runs.lower_bound(from);
+    if (it != m_runs.begin())
+        --it;
+    while (it != m_runs.end() && it->first <= to) {
+        auto next = std::next(it);
+        if (next != m_runs.end() && next->second == it->second) {
+            m_runs.erase(next);
+            continue;
+        }
+        it = next;
+    }
+
+    // An uncovered first run is implied
+    if (!m_runs.empty() && m_runs.begin()->second.empty())
+        m_runs.erase(m_runs.begin());
+}
+
+void SegmentIndex::insert(int segmentId, int firstFrame, int lastFrame)
+{
+    if (lastFrame < firstFrame)
+        return;
+    split(firstFrame);
+    split(lastFrame + 1);
+    for (auto it = m_runs.find(firstFrame); it->first <= lastFrame; ++it) {
+        auto& ids = it->second;
+        ids.insert(std::lower_bound(ids.begin(), ids.end(), segmentId), segmentId);
+    }
+    coalesce(firstFrame, lastFrame + 1);
+}
+
+void SegmentIndex::remove(int segmentId, int firstFrame, int lastFrame)
+{
+    if (lastFrame < firstFrame)
+        return;
+    split(firstFrame);
+    split(lastFrame + 1);
+    for (auto it = m_runs.find(firstFrame); it->first <= lastFrame; ++it) {
+        auto& ids = it->second;
+        auto pos = std::lower_bound(ids.begin(), ids.end(), segmentId);
+        if (pos != ids.end() && *pos == segmentId)
+            ids.erase(pos);
+    }
+    coalesce(firstFrame, lastFrame + 1);
+}
+
+const std::vector<int>& SegmentIndex::segmentsAt(int frame) const
+{
+    static const std::vector<int> none;
+    auto it = m_runs.upper_bound(frame);
+    if (it == m_runs.begin())
+        return none;
+    return std::prev(it)->second;
+}
+
+std::vector<SegmentIndex::Interval> SegmentIndex::coverage() const
+{
+    std::vector<Interval> intervals;
+    for (auto it = m_runs.begin(); it != m_runs.end(); ++it) {
+        auto next = std::next(it);
+        if (it->second.empty() || next == m_runs.end())
+            continue;
+        Interval interval;
+        interval.first = it->first;
+        interval.last = next->first - 1;
+        interval.count = static_cast<int>(it->second.size());
+        intervals.push_back(interval);
+    }
+    return intervals;
+}
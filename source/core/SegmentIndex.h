@@ -0,0 +1,34 @@
+#pragma once
+
+#include <map>
+#include <vector>
+
+// Which accepted segments cover each frame, kept as a sorted coverage map:
+// every key starts a run of frames covered by the same set of segments,
+// lasting until the next key. Frames before the first key are uncovered.
+// Inserting or removing a segment only touches the runs inside its range.
+class SegmentIndex {
+public:
+    // Frames first..last, covered by count segments
+    struct Interval {
+        int first = 0;
+        int last = 0;
+        int count = 0;
+    };
+
+    void insert(int segmentId, int firstFrame, int lastFrame);
+    void remove(int segmentId, int firstFrame, int lastFrame);
+    void clear() { m_runs.clear(); }
+
+    // Ids of the segments covering frame, ascending
+    const std::vector<int>& segmentsAt(int frame) const;
+
+    // Covered runs in frame order
+    std::vector<Interval> coverage() const;
+
+private:
+    void split(int frame);
+    void coalesce(int from, int to);
+
+    std::map<int, std::vector<int>> m_runs; // run start -> sorted segment ids
+};
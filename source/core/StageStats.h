@@ -0,0 +1,19 @@
+#pragma once
+
+// Snapshot of one stage of the tracking pipeline. Readers derive throughput
+// from the change in processed between two snapshots.
+struct StageStats {
+    unsigned long long processed = 0; // frames through the stage so far
+    unsigned long long dropped = 0;   // frames discarded to keep up
+    int                depth = 0;     // frames waiting at the stage's output
+    int                capacity = 0;
+
+    StageStats& operator+=(const StageStats& other)
+    {
+        processed += other.processed;
+        dropped += other.dropped;
+        depth += other.depth;
+        capacity += other.capacity;
+        return *this;
+    }
+};
@@ -0,0 +1,272 @@
+#include "TrackResultCache.h"
+#include "TrackingWorker.h"
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QStandardPaths>
+#include <QThread>
+#include <algorithm>
+
+static constexpr quint32 kEntryMagic   = 0x47545452; // "GTTR"
+static constexpr quint32 kEntryVersion = 2;
+
+// Box count of the record that marks a run as complete
+static constexpr qint32 kCompleteMarker = -1;
+
+// The fingerprint reads this many evenly spaced blocks of the video file
+static constexpr int    kFingerprintSamples = 16;
+static constexpr qint64 kFingerprintBlock = 64 * 1024;
+
+TrackResultCache::TrackResultCache(const QString& directory)
+    : m_directory(directory)
+{
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->start();
+}
+
+TrackResultCache::~TrackResultCache()
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        m_stopping = true;
+        m_wake.wakeAll();
+    }
+    m_thread->wait();
+    delete m_thread;
+}
+
+QString TrackResultCache::defaultDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+           + QStringLiteral("/tracks");
+}
+
+QByteArray TrackResultCache::fingerprint(const QString& videoPath)
+{
+    QFileInfo info(videoPath);
+    QString memoKey = QString("%1|%2|%3").arg(videoPath).arg(info.size())
+                          .arg(info.lastModified().toMSecsSinceEpoch());
+    auto it = m_fingerprints.constFind(memoKey);
+    if (it != m_fingerprints.constEnd())
+        return it.value();
+
+    // Size plus a handful of blocks spread over the file: enough to tell
+    // videos apart without reading gigabytes
+    QFile file(videoPath);
+    if (!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    qint64 size = file.size();
+    hash.addData(QByteArray::number(size));
+    for (int i = 0; i < kFingerprintSamples; ++i) {
+        qint64 offset = (size - kFingerprintBlock) * i / (kFingerprintSamples - 1);
+        file.seek(std::max<qint64>(0, offset));
+        hash.addData(file.read(kFingerprintBlock));
+    }
+    QByteArray result = hash.result();
+    m_fingerprints.insert(memoKey, result);
+    return result;
+}
+
+QByteArray TrackResultCache::key(const QString& videoPath, int startFrame, int direction,
+                                 const TrackingOptions& options,
+                                 const std::vector<BoundingBox>& initialBoxes,
+                                 const std::vector<TrackerBackend>& backends)
+{
+    QByteArray video = fingerprint(videoPath);
+    if (video.isEmpty())
+        return QByteArray();
+
+    // Everything that changes what the trackers produce. The stop frame is
+    // left out: runs of different lengths share an entry.
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out << video << qint32(startFrame) << qint32(direction)
+        << qint32(options.scale) << qint32(options.stride)
+        << options.consistencyScoring << qint32(options.fpsBudget)
+        << quint32(initialBoxes.size());
+    for (size_t i = 0; i < initialBoxes.size(); ++i) {
+        const QRectF& r = initialBoxes[i].rect;
+        TrackerBackend backend = i < backends.size() ? backends[i] : TrackerBackend::KCF;
+        out << qint32(backend) << r.x() << r.y() << r.width() << r.height();
+    }
+    return QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex();
+}
+
+QString TrackResultCache::entryPath(const QByteArray& key) const
+{
+    return m_directory + '/' + QString::fromLatin1(key) + QStringLiteral(".gttrk");
+}
+
+bool TrackResultCache::read(const QString& path, Entry& entry,
+                            const std::vector<BoundingBox>* initialBoxes,
+                            qint64* validSize) const
+{
+    if (validSize)
+        *validSize = 0;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream in(&file);
+    quint32 magic = 0, version = 0;
+    in >> magic >> version;
+    if (in.status() != QDataStream::Ok || magic != kEntryMagic || version != kEntryVersion)
+        return false;
+
+    // Records up to the first incomplete one, which a crash while
+    // appending can leave behind
+    Entry result;
+    qint64 valid = file.pos();
+    while (!in.atEnd()) {
+        qint32 frameIndex = 0, count = 0;
+        in >> frameIndex >> count;
+        if (in.status() != QDataStream::Ok)
+            break;
+        if (count == kCompleteMarker) {
+            result.complete = true;
+            valid = file.pos();
+            continue;
+        }
+        if (count < 0)
+            break;
+        auto fa = std::make_shared<FrameAnnotation>();
+        fa->frameIndex = frameIndex;
+        fa->boxes.resize(static_cast<size_t>(count));
+        for (auto& box : fa->boxes) {
+            double x = 0, y = 0, w = 0, h = 0;
+            in >> x >> y >> w >> h >> box.confidence;
+            box.rect = QRectF(x, y, w, h);
+        }
+        if (in.status() != QDataStream::Ok)
+            break;
+        if (initialBoxes) {
+            fa->boxes.resize(std::min(fa->boxes.size(), initialBoxes->size()));
+            for (size_t i = 0; i < fa->boxes.size(); ++i) {
+                fa->boxes[i].trackId = (*initialBoxes)[i].trackId;
+                fa->boxes[i].labelId = (*initialBoxes)[i].labelId;
+            }
+        }
+        result.frames[frameIndex] = std::move(fa);
+        valid = file.pos();
+    }
+
+    entry = std::move(result);
+    if (validSize)
+        *validSize = valid;
+    return true;
+}
+
+bool TrackResultCache::load(const QByteArray& key, const std::vector<BoundingBox>& initialBoxes,
+                            Entry& entry)
+{
+    if (key.isEmpty())
+        return false;
+    {
+        QMutexLocker lock(&m_mutex);
+        while (!m_queue.empty() || m_writing)
+            m_idle.wait(&m_mutex);
+    }
+    return read(entryPath(key), entry, &initialBoxes);
+}
+
+void TrackResultCache::append(const QByteArray& key, std::vector<FrameAnnotationPtr> frames,
+                              bool complete)
+{
+    if (key.isEmpty() || (frames.empty() && !complete))
+        return;
+
+    // The records are immutable, so the writer can use them as they are
+    QMutexLocker lock(&m_mutex);
+    Append job;
+    job.path = entryPath(key);
+    job.frames = std::move(frames);
+    job.complete = complete;
+    m_queue.push_back(std::move(job));
+    m_wake.wakeAll();
+}
+
+void TrackResultCache::run()
+{
+    QMutexLocker lock(&m_mutex);
+    for (;;) {
+        if (m_queue.empty()) {
+            m_writing = false;
+            m_idle.wakeAll();
+            if (m_stopping)
+                return;
+            m_wake.wait(&m_mutex);
+            continue;
+        }
+
+        Append job = std::move(m_queue.front());
+        m_queue.pop_front();
+        m_writing = true;
+        lock.unlock();
+        write(job);
+        lock.relock();
+    }
+}
+
+bool TrackResultCache::openForAppend(const QString& path, QFile& file)
+{
+    // The first time an entry is opened, a record torn by a crash is cut
+    // off, and a file that is no valid entry is started over
+    bool checked = m_checked.contains(path);
+    qint64 valid = 0;
+    if (!checked) {
+        Entry existing;
+        read(path, existing, nullptr, &valid);
+    }
+
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadWrite))
+        return false;
+    if (!checked) {
+        if (!file.resize(valid))
+            return false;
+        m_checked.insert(path);
+    }
+    if (file.size() > 0)
+        return file.seek(file.size());
+
+    QDataStream out(&file);
+    out << kEntryMagic << kEntryVersion;
+    prune();
+    return out.status() == QDataStream::Ok;
+}
+
+bool TrackResultCache::write(const Append& job)
+{
+    if (!QDir().mkpath(m_directory))
+        return false;
+
+    QFile file;
+    if (!openForAppend(job.path, file))
+        return false;
+
+    QDataStream out(&file);
+    for (const auto& frame : job.frames) {
+        const auto& boxes = frame->boxes;
+        out << static_cast<qint32>(frame->frameIndex) << static_cast<qint32>(boxes.size());
+        for (const auto& box : boxes)
+            out << box.rect.x() << box.rect.y() << box.rect.width() << box.rect.height()
+                << box.confidence;
+    }
+    if (job.complete)
+        out << qint32(0) << kCompleteMarker;
+    return out.status() == QDataStream::Ok && file.flush();
+}
+
+void TrackResultCache::prune()
+{
+    QDir dir(m_directory);
+    QFileInfoList entries = dir.entryInfoList({QStringLiteral("*.gttrk")}, QDir::Files,
+                                              QDir::Time);
+    for (int i = kMaxEntries; i < entries.size(); ++i)
+        QFile::remove(entries[i].absoluteFilePath());
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QString>
+#include <QWaitCondition>
+#include <deque>
+#include <map>
+#include <vector>
+#include "AnnotationData.h"
+#include "TrackerFactory.h"
+
+class QFile;
+class QThread;
+struct TrackingOptions;
+
+// Tracked trajectories persisted across runs and application restarts, so
+// re-running the same boxes from the same frame replays instead of tracking
+// again. An entry is keyed by a sampled fingerprint of the video file, the
+// start frame, the direction, the tracker configuration and the initial
+// box rectangles. Track and label ids are not part of the key: boxes are
+// stored in tracker order and take their ids from the initial boxes again.
+// Frames are held as shared records, so replaying hands out the same
+// objects the engine keeps instead of copies.
+//
+// An entry file is a header followed by frame records that are only ever
+// appended, by a writer thread of the cache's own. Frames are stored while
+// a run is in progress, so a crash loses at most the frames not yet
+// appended, and storing never waits on the disk.
+class TrackResultCache {
+public:
+    using Trajectory = std::map<int, FrameAnnotationPtr>;
+
+    struct Entry {
+        Trajectory frames;           // by frame, without the start frame
+        bool       complete = false; // ran to the end of the video
+    };
+
+    explicit TrackResultCache(const QString& directory = defaultDirectory());
+    ~TrackResultCache(); // writes out everything still queued
+
+    TrackResultCache(const TrackResultCache&) = delete;
+    TrackResultCache& operator=(const TrackResultCache&) = delete;
+
+    QByteArray key(const QString& videoPath, int startFrame, int direction,
+                   const TrackingOptions& options,
+                   const std::vector<BoundingBox>& initialBoxes,
+                   const std::vector<TrackerBackend>& backends);
+
+    // Boxes come back with the ids of initialBoxes, matched by position.
+    // Waits for queued appends first, so earlier runs are seen in full.
+    bool load(const QByteArray& key, const std::vector<BoundingBox>& initialBoxes,
+              Entry& entry);
+
+    // Queues frames to be appended to the entry under key. Nothing stored
+    // is discarded: a frame stored again replaces the earlier record when
+    // loaded. complete marks the run as having reached the end of the video.
+    void append(const QByteArray& key, std::vector<FrameAnnotationPtr> frames, bool complete);
+
+    static QString defaultDirectory();
+
+private:
+    struct Append {
+        QString                         path;
+        std::vector<FrameAnnotationPtr> frames;
+        bool                            complete = false;
+    };
+
+    QByteArray fingerprint(const QString& videoPath);
+    QString    entryPath(const QByteArray& key) const;
+    // With initialBoxes, ids are assigned while the records are built.
+    // validSize receives the length of the header and the whole records.
+    bool       read(const QString& path, Entry& entry,
+                    const std::vector<BoundingBox>* initialBoxes = nullptr,
+                    qint64* validSize = nullptr) const;
+    void       run();
+    bool       write(const Append& job);
+    bool       openForAppend(const QString& path, QFile& file);
+    void       prune();
+
+    // Oldest entries beyond this count are deleted when a new one is created
+    static constexpr int kMaxEntries = 256;
+
+    QString                    m_directory;
+    QHash<QString, QByteArray> m_fingerprints; // by video path
+
+    QThread*                   m_thread = nullptr;
+    QMutex                     m_mutex;
+    QWaitCondition             m_wake; // GUI -> writer
+    QWaitCondition             m_idle; // writer -> load()
+    std::deque<Append>         m_queue;
+    bool                       m_writing = false;
+    bool                       m_stopping = false;
+    QSet<QString>              m_checked; // entries opened by the writer so far
+};
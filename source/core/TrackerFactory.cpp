@@ -0,0 +1,74 @@
+#include "TrackerFactory.h"
+#include "CorrelationTracker.h"
+#include <QCoreApplication>
+#include <opencv2/tracking/tracking_legacy.hpp>
+
+cv::Ptr<cv::Tracker> TrackerFactory::create(TrackerBackend backend)
+{
+    switch (backend) {
+    case TrackerBackend::KCF:
+        return cv::TrackerKCF::create();
+    case TrackerBackend::CSRT:
+        return cv::TrackerCSRT::create();
+    case TrackerBackend::MIL:
+        return cv::TrackerMIL::create();
+    // MOSSE and MedianFlow only exist in the legacy API
+    case TrackerBackend::MOSSE:
+        return cv::legacy::upgradeTrackingAPI(cv::legacy::TrackerMOSSE::create());
+    case TrackerBackend::MedianFlow:
+        return cv::legacy::upgradeTrackingAPI(cv::legacy::TrackerMedianFlow::create());
+    // The worker batches these itself; one-off users get a single target
+    case TrackerBackend::BatchMOSSE:
+        return cv::makePtr<CorrelationTrackerAdapter>();
+    }
+    return cv::TrackerKCF::create();
+}
+
+TrackerInput TrackerFactory::input(TrackerBackend backend)
+{
+    switch (backend) {
+    // MOSSE, MIL and MedianFlow only look at intensity. KCF and CSRT add
+    // colour-name features when given colour, so they keep it.
+    case TrackerBackend::MOSSE:
+    case TrackerBackend::MIL:
+    case TrackerBackend::MedianFlow:
+    case TrackerBackend::BatchMOSSE:
+        return TrackerInput::Gray;
+    case TrackerBackend::KCF:
+    case TrackerBackend::CSRT:
+        break;
+    }
+    return TrackerInput::Color;
+}
+
+QString TrackerFactory::name(TrackerBackend backend)
+{
+    switch (backend) {
+    case TrackerBackend::KCF:        return QStringLiteral("KCF");
+    case TrackerBackend::CSRT:       return QStringLiteral("CSRT");
+    case TrackerBackend::MOSSE:      return QStringLiteral("MOSSE");
+    case TrackerBackend::MIL:        return QStringLiteral("MIL");
+    case TrackerBackend::MedianFlow: return QStringLiteral("MedianFlow");
+    case TrackerBackend::BatchMOSSE: return QStringLiteral("Batch MOSSE");
+    }
+    return QString();
+}
+
+const std::vector<TrackerBackend>& TrackerFactory::backends()
+{
+    static const std::vector<TrackerBackend> all = {
+        TrackerBackend::KCF, TrackerBackend::BatchMOSSE, TrackerBackend::CSRT,
+        TrackerBackend::MOSSE, TrackerBackend::MIL, TrackerBackend::MedianFlow
+    };
+    return all;
+}
+
+const std::vector<TrackerProfile>& TrackerFactory::profiles()
+{
+    static const std::vector<TrackerProfile> all = {
+        { QCoreApplication::translate("TrackerFactory", "Fast"),     TrackerBackend::MOSSE },
+        { QCoreApplication::translate("TrackerFactory", "Balanced"), TrackerBackend::KCF },
+        { QCoreApplication::translate("TrackerFactory", "Accurate"), TrackerBackend::CSRT },
+    };
+    return all;
+}
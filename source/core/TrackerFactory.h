@@ -0,0 +1,44 @@
+#pragma once
+
+#include <QString>
+#include <opencv2/tracking.hpp>
+#include <vector>
+
+enum class TrackerBackend {
+    KCF,
+    CSRT,
+    MOSSE,
+    MIL,
+    MedianFlow,
+    BatchMOSSE  // CorrelationTracker, all boxes updated in one call
+};
+
+// Image a backend works on. Trackers that convert to grayscale internally
+// are handed the shared gray frame instead, so the conversion runs once per
+// frame rather than once per tracker.
+enum class TrackerInput {
+    Color,
+    Gray
+};
+
+// Named speed/accuracy trade-offs shown to annotators
+struct TrackerProfile {
+    QString        name;
+    TrackerBackend backend;
+};
+
+// Measured update rate of one tracker of a backend
+struct BackendSpeed {
+    TrackerBackend backend = TrackerBackend::KCF;
+    double         fps = 0.0;
+};
+
+class TrackerFactory {
+public:
+    static cv::Ptr<cv::Tracker> create(TrackerBackend backend);
+
+    static TrackerInput input(TrackerBackend backend);
+    static QString name(TrackerBackend backend);
+    static const std::vector<TrackerBackend>& backends();
+    static const std::vector<TrackerProfile>& profiles();
+};
@@ -1,86 +1,340 @@
 #include "TrackingEngine.h"
 #include "VideoManager.h"
+#include <QThread>
 
 TrackingEngine::TrackingEngine(VideoManager* videoManager, QObject* parent)
     : QObject(parent)
     , m_videoManager(videoManager)
 {
-    m_stepTimer = new QTimer(this);
-    m_stepTimer->setInterval(0); // Process as fast as possible
-    connect(m_stepTimer, &QTimer::timeout, this, &TrackingEngine::processNextFrame);
+    qRegisterMetaType<FrameAnnotationPtr>();
+    qRegisterMetaType<cv::Mat>();
+    qRegisterMetaType<std::vector<BackendSpeed>>();
+
+    m_lanes[kBackward].direction = -1;
+    for (Lane& lane : m_lanes) {
+        lane.thread = new QThread(this);
+        lane.worker = new TrackingWorker;
+        lane.worker->moveToThread(lane.thread);
+
+        Lane* l = &lane;
+        connect(lane.worker, &TrackingWorker::frameTracked, this,
+                [this, l](unsigned session, const FrameAnnotationPtr& annotation,
+                          const cv::Mat& frame) {
+                    onWorkerFrameTracked(*l, session, annotation, frame);
+                }, Qt::QueuedConnection);
+        connect(lane.worker, &TrackingWorker::speedMeasured, this,
+                [this](unsigned session, const std::vector<BackendSpeed>& speeds) {
+                    if (session == m_session)
+                        emit speedMeasured(speeds);
+                }, Qt::QueuedConnection);
+        connect(lane.worker, &TrackingWorker::finished, this,
+                [this, l](unsigned session) { onWorkerFinished(*l, session); },
+                Qt::QueuedConnection);
+        connect(lane.worker, &TrackingWorker::error,
+                this, &TrackingEngine::onWorkerError, Qt::QueuedConnection);
+
+        lane.thread->start();
+    }
+}
+
+TrackingEngine::~TrackingEngine()
+{
+    stop();
+    for (Lane& lane : m_lanes) {
+        lane.thread->quit();
+        lane.thread->wait();
+        delete lane.worker;
+    }
 }
 
 void TrackingEngine::initialize(const cv::Mat& frame, int frameIndex,
-                                 const std::vector<BoundingBox>& initialBoxes)
+                                 const std::vector<BoundingBox>& initialBoxes,
+                                 const std::vector<TrackerBackend>& perBoxBackends)
 {
     reset();
-    m_trackingFrameIndex = frameIndex;
-
-    for (const auto& box : initialBoxes) {
-        TrackerInstance inst;
-        inst.tracker = cv::TrackerKCF::create();
-        cv::Rect2d roi(box.rect.x(), box.rect.y(),
-                       box.rect.width(), box.rect.height());
-        inst.tracker->init(frame, roi);
-        inst.box = box;
-        m_trackers.push_back(std::move(inst));
+    m_trackerCount = initialBoxes.size();
+    m_sessionOptions = m_options;
+    auto initial = std::make_shared<FrameAnnotation>();
+    initial->frameIndex = frameIndex;
+    initial->boxes = initialBoxes;
+    for (Lane& lane : m_lanes)
+        lane.trajectory[frameIndex] = initial;
+
+    std::vector<TrackerBackend> backends(initialBoxes.size(), m_backend);
+    for (size_t i = 0; i < perBoxBackends.size() && i < backends.size(); ++i)
+        backends[i] = perBoxBackends[i];
+
+    TrackingWorker::Source source;
+    source.path = m_videoManager->filePath();
+    source.keyframes = m_videoManager->keyframeIndex();
+    source.cache = m_videoManager->frameCache();
+
+    // Queued behind any run that is still winding down after reset()
+    unsigned session = m_session;
+    TrackingOptions options = m_sessionOptions;
+    for (Lane& lane : m_lanes) {
+        lane.frameIndex = frameIndex;
+        lane.startFrame = frameIndex;
+        if (lane.direction < 0 && !options.bidirectional)
+            continue;
+        lane.cacheKey = m_resultCache.key(source.path, frameIndex, lane.direction, options,
+                                          initialBoxes, backends);
+        m_resultCache.load(lane.cacheKey, initialBoxes, lane.cached);
+
+        int direction = lane.direction;
+        TrackingWorker* worker = lane.worker;
+        QMetaObject::invokeMethod(worker, [=]() {
+            worker->initialize(source, options, direction, frame, frameIndex,
+                               initialBoxes, backends, session);
+        }, Qt::QueuedConnection);
     }
 }
 
 void TrackingEngine::start()
 {
-    if (m_trackers.empty()) {
+    if (m_trackerCount == 0) {
         emit trackingError(tr("No boxes to track. Draw bounding boxes first."));
         return;
     }
-    m_running = true;
-    m_stepTimer->start();
+    if (isRunning())
+        return;
+
+    m_cancel = std::make_shared<std::atomic<bool>>(false);
+
+    unsigned session = m_session;
+    CancelToken cancel = m_cancel;
+    for (Lane& lane : m_lanes) {
+        if (lane.direction < 0 && !m_sessionOptions.bidirectional)
+            continue;
+        lane.running = true;
+
+        // Cached frames are emitted from the event loop, ahead of anything
+        // the worker delivers, and the worker picks up where they end
+        std::vector<FrameAnnotationPtr> frames;
+        bool covered = takeReplay(lane, frames);
+        if (!frames.empty() || covered) {
+            Lane* l = &lane;
+            QMetaObject::invokeMethod(this, [=]() {
+                replay(*l, session, frames, covered);
+            }, Qt::QueuedConnection);
+        }
+        if (covered)
+            continue;
+
+        TrackingWorker* worker = lane.worker;
+        if (!frames.empty()) {
+            FrameAnnotationPtr last = frames.back();
+            QMetaObject::invokeMethod(worker, [=]() {
+                worker->rewind(last->frameIndex, last->boxes, session);
+            }, Qt::QueuedConnection);
+        }
+        QMetaObject::invokeMethod(worker, [=]() {
+            worker->run(session, cancel);
+        }, Qt::QueuedConnection);
+    }
+}
+
+bool TrackingEngine::takeReplay(Lane& lane, std::vector<FrameAnnotationPtr>& frames)
+{
+    // Cached frames continuing from where the lane stands, up to the stop
+    // frame or the first gap
+    const TrackResultCache::Trajectory& cached = lane.cached.frames;
+    const int stopFrame = lane.direction > 0 ? m_sessionOptions.stopFrame : 0;
+    int frame = lane.frameIndex;
+    for (;;) {
+        int next = frame + lane.direction;
+        if (next < 0 || (stopFrame >= 0 && lane.direction * (next - stopFrame) > 0))
+            break;
+        auto it = cached.find(next);
+        if (it == cached.end())
+            break;
+        frames.push_back(it->second);
+        frame = next;
+    }
+
+    // Nothing is left to track if the cache reaches the stop frame, or ran to
+    // the end of the video and the replay got through all of it
+    bool covered = stopFrame >= 0 && frame == stopFrame;
+    if (lane.cached.complete && !cached.empty()) {
+        int last = lane.direction > 0 ? cached.rbegin()->first : cached.begin()->first;
+        covered = covered || frame == last;
+    }
+    lane.cached = TrackResultCache::Entry();
+    return covered;
+}
+
+void TrackingEngine::replay(Lane& lane, unsigned session,
+                            const std::vector<FrameAnnotationPtr>& frames, bool covered)
+{
+    if (session != m_session)
+        return;
+
+    // Emitted even after a stop(): the worker was already rewound past them
+    for (const auto& fa : frames) {
+        lane.frameIndex = fa->frameIndex;
+        lane.trajectory[fa->frameIndex] = fa;
+        emit frameTracked(fa, cv::Mat());
+    }
+    if (covered)
+        onWorkerFinished(lane, session);
+}
+
+void TrackingEngine::storeResults(Lane& lane)
+{
+    // Only queued here; the cache appends them on its own thread
+    if (!lane.cacheKey.isEmpty())
+        m_resultCache.append(lane.cacheKey, std::move(lane.unsaved), lane.complete);
+    lane.unsaved.clear();
+    lane.complete = false;
 }
 
 void TrackingEngine::stop()
 {
-    m_running = false;
-    m_stepTimer->stop();
+    for (Lane& lane : m_lanes) {
+        lane.running = false;
+        storeResults(lane);
+    }
+    if (m_cancel) {
+        *m_cancel = true;
+        for (Lane& lane : m_lanes)
+            lane.worker->wakeDelivery();
+    }
 }
 
 void TrackingEngine::reset()
 {
     stop();
-    m_trackers.clear();
-    m_trackingFrameIndex = 0;
+    ++m_session;
+    m_trackerCount = 0;
+
+    for (Lane& lane : m_lanes) {
+        lane.frameIndex = 0;
+        lane.startFrame = 0;
+        lane.trajectory.clear();
+        lane.cacheKey.clear();
+        lane.cached = TrackResultCache::Entry();
+        lane.complete = false;
+        lane.unsaved.clear();
+        TrackingWorker* worker = lane.worker;
+        QMetaObject::invokeMethod(worker, [worker]() { worker->clear(); },
+                                  Qt::QueuedConnection);
+    }
 }
 
-void TrackingEngine::processNextFrame()
+std::vector<BoundingBox> TrackingEngine::checkpoint(int frameIndex, int* checkpointFrame) const
 {
-    int nextFrame = m_trackingFrameIndex + 1;
-    if (nextFrame >= m_videoManager->totalFrames()) {
-        stop();
-        emit trackingFinished();
+    const auto& checkpoints = m_lanes[kForward].trajectory;
+    auto it = checkpoints.upper_bound(frameIndex);
+    if (it == checkpoints.begin())
+        return {};
+    --it;
+    if (checkpointFrame)
+        *checkpointFrame = it->first;
+    return it->second->boxes;
+}
+
+void TrackingEngine::resumeFrom(int frameIndex, const std::vector<BoundingBox>& boxes)
+{
+    // The workers keep their decoders, options and backends; only the
+    // trackers restart, so this costs one frame regardless of how far
+    // tracking had got
+    stop();
+    ++m_session;
+    m_trackerCount = boxes.size();
+
+    // Corrected boxes start a run of their own, which is not cached
+    Lane& lane = m_lanes[kForward];
+    lane.trajectory.erase(lane.trajectory.upper_bound(frameIndex), lane.trajectory.end());
+    auto corrected = std::make_shared<FrameAnnotation>();
+    corrected->frameIndex = frameIndex;
+    corrected->boxes = boxes;
+    lane.trajectory[frameIndex] = std::move(corrected);
+    lane.cacheKey.clear();
+    lane.cached = TrackResultCache::Entry();
+    lane.frameIndex = frameIndex;
+    unsigned session = m_session;
+    TrackingWorker* worker = lane.worker;
+    QMetaObject::invokeMethod(worker, [=]() {
+        worker->rewind(frameIndex, boxes, session);
+    }, Qt::QueuedConnection);
+
+    // The new session drops the backward results still in flight too, so
+    // that direction goes back to the last frame it delivered
+    if (!m_sessionOptions.bidirectional)
         return;
-    }
+    Lane& backward = m_lanes[kBackward];
+    auto it = backward.trajectory.find(backward.frameIndex);
+    if (it == backward.trajectory.end())
+        return;
+    int backwardFrame = backward.frameIndex;
+    std::vector<BoundingBox> backwardBoxes = it->second->boxes;
+    TrackingWorker* backwardWorker = backward.worker;
+    QMetaObject::invokeMethod(backwardWorker, [=]() {
+        backwardWorker->rewind(backwardFrame, backwardBoxes, session);
+    }, Qt::QueuedConnection);
+}
+
+bool TrackingEngine::isRunning() const
+{
+    for (const Lane& lane : m_lanes)
+        if (lane.running)
+            return true;
+    return false;
+}
+
+StageStats TrackingEngine::decodeStats() const
+{
+    StageStats stats;
+    for (const Lane& lane : m_lanes)
+        stats += lane.worker->decodeStats();
+    return stats;
+}
 
-    cv::Mat frame = m_videoManager->getFrame(nextFrame);
-    if (frame.empty()) {
-        stop();
-        emit trackingError(tr("Failed to read frame %1").arg(nextFrame));
+StageStats TrackingEngine::trackStats() const
+{
+    StageStats stats;
+    for (const Lane& lane : m_lanes)
+        stats += lane.worker->trackStats();
+    return stats;
+}
+
+void TrackingEngine::onWorkerFrameTracked(Lane& lane, unsigned session,
+                                          const FrameAnnotationPtr& annotation,
+                                          const cv::Mat& frame)
+{
+    lane.worker->frameDelivered();
+    if (session != m_session)
         return;
-    }
 
-    m_trackingFrameIndex = nextFrame;
-
-    std::vector<BoundingBox> updatedBoxes;
-    for (auto& inst : m_trackers) {
-        cv::Rect roi;
-        bool ok = inst.tracker->update(frame, roi);
-        if (ok) {
-            inst.box.rect = QRectF(roi.x, roi.y, roi.width, roi.height);
-            inst.box.confidence = 1.0;
-        } else {
-            // Tracker lost - keep last known position but lower confidence
-            inst.box.confidence = 0.0;
-        }
-        updatedBoxes.push_back(inst.box);
+    lane.frameIndex = annotation->frameIndex;
+    lane.trajectory[annotation->frameIndex] = annotation;
+    if (!lane.cacheKey.isEmpty()) {
+        lane.unsaved.push_back(annotation);
+        if (lane.unsaved.size() >= kStoreBatch)
+            storeResults(lane);
     }
+    emit frameTracked(annotation, frame);
+}
+
+void TrackingEngine::onWorkerFinished(Lane& lane, unsigned session)
+{
+    if (session != m_session || !lane.running)
+        return;
+    lane.running = false;
+    lane.complete = lane.direction < 0 || m_sessionOptions.stopFrame < 0;
+    storeResults(lane);
+
+    // Reported once, when the last running direction is done
+    if (!isRunning())
+        emit trackingFinished();
+}
 
-    emit frameTracked(m_trackingFrameIndex, updatedBoxes);
+void TrackingEngine::onWorkerError(unsigned session, const QString& message)
+{
+    if (session != m_session)
+        return;
+
+    // One failing direction stops the other as well
+    stop();
+    emit trackingError(message);
 }
@@ -1,45 +1,129 @@
 #pragma once
 
 #include <QObject>
-#include <QTimer>
 #include <opencv2/core.hpp>
-#include <opencv2/tracking.hpp>
+#include <algorithm>
+#include <map>
 #include <vector>
 #include "AnnotationData.h"
+#include "TrackResultCache.h"
+#include "TrackingWorker.h"
 
+class QThread;
 class VideoManager;
 
+// GUI-thread front end of the tracker. Each tracking direction runs on its
+// own thread (see TrackingWorker) and results arrive through queued signals.
 class TrackingEngine : public QObject {
     Q_OBJECT
 public:
     explicit TrackingEngine(VideoManager* videoManager, QObject* parent = nullptr);
+    ~TrackingEngine();
 
+    // Session-wide tracker backend, used for boxes without an override
+    void setBackend(TrackerBackend backend) { m_backend = backend; }
+    TrackerBackend backend() const { return m_backend; }
+
+    // Downscale divisor for tracking, or TrackingOptions::kAutoScale
+    void setTrackingScale(int scale) { m_options.scale = scale; }
+
+    // Update the trackers every stride-th frame and interpolate in between
+    void setStride(int stride) { m_options.stride = std::max(1, stride); }
+
+    // Tracker updates per second to schedule within, 0 for no limit
+    void setFpsBudget(int fps) { m_options.fpsBudget = std::max(0, fps); }
+
+    // Last frame to track forwards to, -1 for the end of the video
+    void setStopFrame(int frame) { m_options.stopFrame = frame; }
+
+    // Track backwards from the initial frame as well as forwards
+    void setBidirectional(bool enabled) { m_options.bidirectional = enabled; }
+    bool isBidirectional() const { return m_options.bidirectional; }
+
+    // Replace the trackers' binary confidence with a forward-backward
+    // round-trip score; results then arrive one verification window late
+    void setConsistencyScoring(bool enabled) { m_options.consistencyScoring = enabled; }
+
+    // perBoxBackends optionally overrides the backend box by box
     void initialize(const cv::Mat& frame, int frameIndex,
-                    const std::vector<BoundingBox>& initialBoxes);
+                    const std::vector<BoundingBox>& initialBoxes,
+                    const std::vector<TrackerBackend>& perBoxBackends = {});
+
+    // Results of an earlier run with the same video, start frame, settings
+    // and boxes are replayed from the result cache first; the trackers only
+    // run past the end of what is cached
     void start();
     void stop();
     void reset();
 
-    bool isRunning() const { return m_running; }
-    int currentTrackingFrame() const { return m_trackingFrameIndex; }
+    // Every forward frame delivered since initialize() is a checkpoint: its
+    // boxes are all the trackers need to be restarted there. Returns the
+    // boxes of the latest checkpoint at or before frameIndex.
+    std::vector<BoundingBox> checkpoint(int frameIndex, int* checkpointFrame = nullptr) const;
+
+    // Stops tracking and restarts the forward trackers at frameIndex with
+    // boxes, e.g. a checkpoint with one box corrected. Later checkpoints
+    // and results still in flight are dropped; start() continues from there.
+    // The backward trackers restart at the last frame they delivered.
+    void resumeFrom(int frameIndex, const std::vector<BoundingBox>& boxes);
+
+    bool isRunning() const;
+
+    // Decode and track stages of both directions combined
+    StageStats decodeStats() const;
+    StageStats trackStats() const;
+
+    // Last frame delivered forwards / backwards; both equal the initial
+    // frame until the respective direction has delivered a result
+    int currentTrackingFrame() const { return m_lanes[kForward].frameIndex; }
+    int firstTrackingFrame() const { return m_lanes[kBackward].frameIndex; }
 
 signals:
-    void frameTracked(int frameIndex, const std::vector<BoundingBox>& boxes);
+    // Frames of the two directions interleave; the record's frameIndex
+    // tells them apart. Replayed frames come with an empty frame.
+    void frameTracked(const FrameAnnotationPtr& annotation, const cv::Mat& frame);
+    void speedMeasured(const std::vector<BackendSpeed>& speeds);
     void trackingFinished();
     void trackingError(const QString& message);
 
-private slots:
-    void processNextFrame();
-
 private:
-    struct TrackerInstance {
-        cv::Ptr<cv::TrackerKCF> tracker;
-        BoundingBox             box;
+    struct Lane {
+        QThread*        thread = nullptr;
+        TrackingWorker* worker = nullptr;
+        int             direction = 1;
+        bool            running = false;
+        int             frameIndex = 0;
+        int             startFrame = 0;
+        TrackResultCache::Trajectory trajectory; // delivered so far, by frame
+        QByteArray      cacheKey;       // empty when results are not cached
+        TrackResultCache::Entry cached; // replayed by the next start()
+        bool            complete = false; // ran to the end, not yet stored
+        std::vector<FrameAnnotationPtr> unsaved; // delivered, not yet stored
     };
 
-    std::vector<TrackerInstance> m_trackers;
-    VideoManager*               m_videoManager;
-    QTimer*                     m_stepTimer;
-    bool                        m_running = false;
-    int                         m_trackingFrameIndex = 0;
+    enum { kForward = 0, kBackward = 1, kLaneCount = 2 };
+
+    // Delivered frames go to the result cache in batches of this many, so
+    // a crash loses at most one batch per direction
+    static constexpr size_t kStoreBatch = 64;
+
+    void onWorkerFrameTracked(Lane& lane, unsigned session,
+                              const FrameAnnotationPtr& annotation,
+                              const cv::Mat& frame);
+    void onWorkerFinished(Lane& lane, unsigned session);
+    void onWorkerError(unsigned session, const QString& message);
+    bool takeReplay(Lane& lane, std::vector<FrameAnnotationPtr>& frames);
+    void replay(Lane& lane, unsigned session, const std::vector<FrameAnnotationPtr>& frames,
+                bool covered);
+    void storeResults(Lane& lane);
+
+    VideoManager*   m_videoManager;
+    Lane            m_lanes[kLaneCount];
+    CancelToken     m_cancel;
+    TrackerBackend  m_backend = TrackerBackend::KCF;
+    TrackingOptions m_options;
+    TrackingOptions m_sessionOptions; // as passed to the current initialize()
+    unsigned        m_session = 0;  // bumped by reset(); stale results are dropped
+    size_t          m_trackerCount = 0;
+    TrackResultCache m_resultCache;
 };
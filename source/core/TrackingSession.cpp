@@ -0,0 +1,68 @@
+#include "TrackingSession.h"
+#include "TrackingEngine.h"
+#include <algorithm>
+
+TrackingSession::TrackingSession(int id, VideoManager* videoManager, QObject* parent)
+    : QObject(parent)
+    , m_id(id)
+    , m_engine(new TrackingEngine(videoManager, this))
+{
+    connect(m_engine, &TrackingEngine::frameTracked, this,
+            [this](const FrameAnnotationPtr& annotation, const cv::Mat&) {
+                // Only boxes are kept; frames are released as they arrive
+                m_annotations.push_back(annotation);
+                m_firstFrame = std::min(m_firstFrame, annotation->frameIndex);
+                m_lastFrame = std::max(m_lastFrame, annotation->frameIndex);
+            });
+    connect(m_engine, &TrackingEngine::trackingFinished, this, [this]() {
+        setState(State::Finished);
+    });
+    connect(m_engine, &TrackingEngine::trackingError, this, [this](const QString& message) {
+        m_error = message;
+        setState(State::Failed);
+    });
+}
+
+void TrackingSession::start(const cv::Mat& frame, int frameIndex,
+                            const std::vector<BoundingBox>& initialBoxes)
+{
+    m_annotations.clear();
+    m_error.clear();
+    m_startFrame = m_firstFrame = m_lastFrame = frameIndex;
+    m_trackCount = initialBoxes.size();
+
+    auto initial = std::make_shared<FrameAnnotation>();
+    initial->frameIndex = frameIndex;
+    initial->boxes = initialBoxes;
+    m_annotations.push_back(std::move(initial));
+
+    m_engine->initialize(frame, frameIndex, initialBoxes);
+    m_engine->start();
+    setState(State::Running);
+}
+
+void TrackingSession::stop()
+{
+    if (m_state != State::Running)
+        return;
+    m_engine->stop();
+    setState(State::Stopped);
+}
+
+std::vector<FrameAnnotationPtr> TrackingSession::takeAnnotations()
+{
+    // Backward results arrive interleaved with forward ones
+    std::stable_sort(m_annotations.begin(), m_annotations.end(),
+                     [](const FrameAnnotationPtr& a, const FrameAnnotationPtr& b) {
+                         return a->frameIndex < b->frameIndex;
+                     });
+    std::vector<FrameAnnotationPtr> annotations = std::move(m_annotations);
+    m_annotations.clear();
+    return annotations;
+}
+
+void TrackingSession::setState(State state)
+{
+    m_state = state;
+    emit stateChanged(m_id);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <opencv2/core.hpp>
+#include <vector>
+#include "AnnotationData.h"
+
+class TrackingEngine;
+class VideoManager;
+
+// A tracking run in the background, next to the interactive one. Each
+// session has its own TrackingEngine, and with it its own decoders and
+// threads, and keeps its results until they are accepted or discarded.
+class TrackingSession : public QObject {
+    Q_OBJECT
+public:
+    enum class State { Running, Stopped, Finished, Failed };
+
+    TrackingSession(int id, VideoManager* videoManager, QObject* parent = nullptr);
+
+    int id() const { return m_id; }
+
+    // Configure before start(); the engine's setters apply as for tracking
+    TrackingEngine* engine() const { return m_engine; }
+
+    void start(const cv::Mat& frame, int frameIndex,
+               const std::vector<BoundingBox>& initialBoxes);
+    void stop();
+
+    State   state() const { return m_state; }
+    QString errorMessage() const { return m_error; }
+
+    int startFrame() const { return m_startFrame; }
+    int firstFrame() const { return m_firstFrame; }
+    int lastFrame() const { return m_lastFrame; }
+    size_t trackCount() const { return m_trackCount; }
+
+    // Results in frame order; leaves the session empty
+    std::vector<FrameAnnotationPtr> takeAnnotations();
+
+signals:
+    void stateChanged(int id);
+
+private:
+    void setState(State state);
+
+    int                             m_id;
+    TrackingEngine*                 m_engine;
+    State                           m_state = State::Stopped;
+    QString                         m_error;
+    std::vector<FrameAnnotationPtr> m_annotations;
+    int                             m_startFrame = 0;
+    int                             m_firstFrame = 0;
+    int                             m_lastFrame = 0;
+    size_t                          m_trackCount = 0;
+};
@@ -0,0 +1,692 @@
+#include "TrackingWorker.h"
+#include "FrameCache.h"
+#include "KeyframeIndex.h"
+#include <QMutexLocker>
+#include <opencv2/core/utility.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+
+// Auto scale keeps at least this many pixels along a box's shorter side
+static constexpr double kMinAutoSide = 64.0;
+
+// Backward tracking decodes a GOP at a time; the engine may run two workers
+static constexpr size_t kReverseBudget = size_t(256) << 20; // 256 MiB
+
+// Weight of the newest sample in a tracker's smoothed update cost
+static constexpr double kCostSmoothing = 0.2;
+
+// Round-trip drift, relative to box size, at which confidence drops to 0.5
+static constexpr double kDriftScale = 0.1;
+
+// Confidence an extrapolated box loses once its tracker has gone the
+// longest allowed without an update; less for shorter gaps
+static constexpr double kExtrapolationPenalty = 0.5;
+
+// Center distance between the forward and the round-tripped box, relative
+// to the forward box's size
+static double roundTripDrift(const QRectF& forward, const QRectF& backward)
+{
+    QPointF d = forward.center() - backward.center();
+    double size = std::sqrt(std::max(1.0, forward.width() * forward.height()));
+    return std::hypot(d.x(), d.y()) / size;
+}
+
+static double driftConfidence(double drift)
+{
+    double r = drift / kDriftScale;
+    return 1.0 / (1.0 + r * r);
+}
+
+static BoundingBox lerpBox(const BoundingBox& from, const BoundingBox& to, double u)
+{
+    BoundingBox box = to;
+    box.rect = QRectF(from.rect.x() + (to.rect.x() - from.rect.x()) * u,
+                      from.rect.y() + (to.rect.y() - from.rect.y()) * u,
+                      from.rect.width() + (to.rect.width() - from.rect.width()) * u,
+                      from.rect.height() + (to.rect.height() - from.rect.height()) * u);
+    box.confidence = std::min(from.confidence, to.confidence);
+    return box;
+}
+
+static cv::Rect scaledRoi(const QRectF& rect, int level)
+{
+    double f = 1.0 / (1 << level);
+    return cv::Rect(static_cast<int>(rect.x() * f), static_cast<int>(rect.y() * f),
+                    static_cast<int>(rect.width() * f), static_cast<int>(rect.height() * f));
+}
+
+TrackingWorker::TrackingWorker(QObject* parent)
+    : QObject(parent)
+    , m_reverse(kReverseBudget)
+{
+}
+
+void TrackingWorker::initialize(const Source& source, const TrackingOptions& options,
+                                int direction, const cv::Mat& frame, int frameIndex,
+                                const std::vector<BoundingBox>& initialBoxes,
+                                const std::vector<TrackerBackend>& backends,
+                                unsigned session)
+{
+    clear();
+    m_options = options;
+    m_direction = direction < 0 ? -1 : 1;
+    m_trackingFrameIndex = frameIndex;
+    m_cache = source.cache;
+    m_keyframes = source.keyframes;
+
+    // Keep the decoder open across sessions on the same video
+    if (!m_decoder.isOpened() || m_path != source.path) {
+        m_path = source.path;
+        if (!m_decoder.open(m_path)) {
+            emit error(session, tr("Failed to open video for tracking: %1").arg(m_path));
+            return;
+        }
+    }
+    m_decoder.setKeyframeIndex(source.keyframes);
+
+    for (size_t i = 0; i < initialBoxes.size(); ++i) {
+        TrackerInstance inst;
+        inst.backend = i < backends.size() ? backends[i] : TrackerBackend::KCF;
+        inst.input = TrackerFactory::input(inst.backend);
+        inst.level = pyramidLevel(options, initialBoxes[i].rect);
+        m_trackers.push_back(std::move(inst));
+    }
+    requireFeatures();
+    m_features.build(frame);
+    for (size_t i = 0; i < initialBoxes.size(); ++i)
+        initTracker(m_trackers[i], initialBoxes[i]);
+    m_trackingFrame = frame;
+    m_recoveryFrames = 0;
+    setStride(options.stride);
+
+    // The keyframe itself is the first anchor of consistency scoring
+    m_anchor.frameIndex = frameIndex;
+    m_anchor.boxes = initialBoxes;
+    m_anchor.frame = frame;
+    m_lastSpeedReport = cv::getTickCount();
+}
+
+void TrackingWorker::clear()
+{
+    if (m_scores.valid())
+        m_scores.wait();
+    m_scores = {};
+    m_scoring.clear();
+    m_window.clear();
+    m_anchor = TrackedFrame();
+    m_reverse.clear();
+    m_trackers.clear();
+    for (auto& batch : m_batches)
+        batch.clear();
+    m_features.clearRequirements();
+    m_features.build(cv::Mat());
+    m_trackingFrameIndex = 0;
+    m_trackingFrame = cv::Mat();
+}
+
+bool TrackingWorker::strideTooLarge(const std::vector<BoundingBox>& before,
+                                    const std::vector<BoundingBox>& after)
+{
+    for (size_t i = 0; i < before.size() && i < after.size(); ++i) {
+        // Losing a box on a long step is worth a retry at stride 1
+        if (after[i].confidence <= 0.0) {
+            if (before[i].confidence > 0.0)
+                return true;
+            continue;
+        }
+        if (roundTripDrift(before[i].rect, after[i].rect) > kMaxStrideDisplacement)
+            return true;
+    }
+    return false;
+}
+
+void TrackingWorker::rewind(int frameIndex, const std::vector<BoundingBox>& boxes,
+                            unsigned session)
+{
+    if (!m_decoder.isOpened())
+        return;
+
+    cv::Mat frame = readFrame(frameIndex);
+    if (frame.empty()) {
+        emit error(session, tr("Failed to read frame %1").arg(frameIndex));
+        return;
+    }
+
+    // Results past the rewind point are stale, verified or not
+    if (m_scores.valid())
+        m_scores.wait();
+    m_scores = {};
+    m_scoring.clear();
+    m_window.clear();
+
+    TrackerBackend fallback = m_trackers.empty() ? TrackerBackend::KCF
+                                                 : m_trackers.front().backend;
+    std::vector<TrackerInstance> trackers;
+    for (const auto& box : boxes) {
+        TrackerInstance inst;
+        inst.backend = fallback;
+        for (const auto& old : m_trackers) {
+            if (old.box.trackId == box.trackId) {
+                inst.backend = old.backend;
+                break;
+            }
+        }
+        inst.input = TrackerFactory::input(inst.backend);
+        inst.level = pyramidLevel(m_options, box.rect);
+        trackers.push_back(std::move(inst));
+    }
+    m_trackers = std::move(trackers);
+    for (auto& batch : m_batches)
+        batch.clear();
+
+    requireFeatures();
+    m_features.build(frame);
+    for (size_t i = 0; i < m_trackers.size(); ++i)
+        initTracker(m_trackers[i], boxes[i]);
+
+    m_trackingFrameIndex = frameIndex;
+    m_trackingFrame = frame;
+    m_anchor.frameIndex = frameIndex;
+    m_anchor.boxes = boxes;
+    m_anchor.frame = frame;
+    m_recoveryFrames = 0;
+    setStride(m_options.stride);
+}
+
+void TrackingWorker::initTracker(TrackerInstance& inst, const BoundingBox& box)
+{
+    cv::Rect roi = scaledRoi(box.rect, inst.level);
+    if (inst.backend == TrackerBackend::BatchMOSSE) {
+        CorrelationTracker& batch = m_batches[inst.level];
+        if (inst.batchId < 0)
+            inst.batchId = batch.add(trackerImage(inst), roi);
+        else
+            batch.reset(inst.batchId, trackerImage(inst), roi);
+    } else {
+        inst.tracker = TrackerFactory::create(inst.backend);
+        inst.tracker->init(trackerImage(inst), roi);
+    }
+    inst.box = box;
+    inst.velocity = QPointF();
+    inst.updatedCenter = box.rect.center();
+    inst.span = 0;
+}
+
+void TrackingWorker::setStride(int stride)
+{
+    m_stride = std::max(1, stride);
+
+    // Forward reads skip decoding the frames in between; backward ones go
+    // through the reverse buffer, which decodes whole GOPs regardless
+    if (m_direction > 0)
+        m_decoder.setStride(m_stride, m_trackingFrameIndex);
+}
+
+void TrackingWorker::run(unsigned session, CancelToken cancel)
+{
+    // Cancellation is checked once per frame, so stop() and reset() take
+    // effect before the next frame is decoded
+    while (!*cancel) {
+        // A stride step never runs past either end of the video, and a stop
+        // frame already passed ends the run
+        int lastFrame = m_direction > 0 ? m_decoder.totalFrames() - 1 : 0;
+        if (m_direction > 0 && m_options.stopFrame >= 0)
+            lastFrame = std::min(lastFrame, m_options.stopFrame);
+        int step = std::min(m_stride, m_direction * (lastFrame - m_trackingFrameIndex));
+        if (step <= 0) {
+            flushScoring(session, cancel);
+            emit finished(session);
+            return;
+        }
+        int nextFrame = m_trackingFrameIndex + m_direction * step;
+
+        cv::Mat frame = readFrame(nextFrame);
+        if (frame.empty()) {
+            flushScoring(session, cancel);
+            emit error(session, tr("Failed to read frame %1").arg(nextFrame));
+            return;
+        }
+
+        // Per-step scratch lives in members so a long run reuses it
+        std::vector<BoundingBox>& previousBoxes = m_previousBoxes;
+        previousBoxes.clear();
+        for (const auto& inst : m_trackers)
+            previousBoxes.push_back(inst.box);
+
+        m_features.build(frame);
+
+        for (auto& inst : m_trackers)
+            inst.span += step;
+        schedule();
+        const std::vector<bool>& due = m_due;
+
+        // Trackers are independent, so they update in parallel on OpenCV's
+        // thread pool. Each writes only its own slot, which keeps the output
+        // in m_trackers order.
+        std::vector<BoundingBox> updatedBoxes(m_trackers.size());
+        cv::parallel_for_(cv::Range(0, static_cast<int>(m_trackers.size())),
+                          [&](const cv::Range& range) {
+            for (int i = range.start; i < range.end; ++i)
+                if (due[i] && m_trackers[i].tracker)
+                    updatedBoxes[i] = updateTracker(m_trackers[i], trackerImage(m_trackers[i]));
+        });
+        updateBatches(updatedBoxes, due);
+
+        // Boxes left out by the scheduler keep moving at their last velocity.
+        // Their confidence drops below 1 with the time since the last update,
+        // as interpolated ones do, so results tell them from tracked boxes;
+        // the tracker keeps the confidence of its last real update.
+        for (size_t i = 0; i < m_trackers.size(); ++i) {
+            if (due[i])
+                continue;
+            TrackerInstance& inst = m_trackers[i];
+            inst.box.rect.translate(inst.velocity * step);
+            updatedBoxes[i] = inst.box;
+            double gap = static_cast<double>(std::min(inst.span, kMaxSkipFrames)) / kMaxSkipFrames;
+            updatedBoxes[i].confidence *= 1.0 - kExtrapolationPenalty * gap;
+        }
+
+        reportSpeed(session);
+
+        // Too much motion for one strided update: restart the trackers on the
+        // last accepted frame and cover the same stretch one frame at a time
+        if (step > 1 && strideTooLarge(previousBoxes, updatedBoxes)) {
+            m_features.build(m_trackingFrame);
+            for (size_t i = 0; i < m_trackers.size(); ++i)
+                initTracker(m_trackers[i], previousBoxes[i]);
+            m_recoveryFrames = m_stride;
+            setStride(1);
+            continue;
+        }
+
+        // Frames stepped over get boxes interpolated between the two updates
+        for (int k = 1; k < step; ++k) {
+            TrackedFrame skipped;
+            skipped.frameIndex = m_trackingFrameIndex + m_direction * k;
+            for (size_t i = 0; i < m_trackers.size(); ++i)
+                skipped.boxes.push_back(lerpBox(previousBoxes[i], updatedBoxes[i],
+                                                static_cast<double>(k) / step));
+            if (m_options.consistencyScoring)
+                queueForScoring(session, cancel, std::move(skipped));
+            else
+                deliver(session, cancel, std::move(skipped));
+        }
+
+        m_trackingFrameIndex = nextFrame;
+        m_trackingFrame = frame;
+        if (m_recoveryFrames > 0 && --m_recoveryFrames == 0)
+            setStride(m_options.stride);
+
+        TrackedFrame tracked;
+        tracked.frameIndex = m_trackingFrameIndex;
+        tracked.boxes = std::move(updatedBoxes);
+        tracked.frame = frame;
+        if (m_options.consistencyScoring)
+            queueForScoring(session, cancel, std::move(tracked));
+        else
+            deliver(session, cancel, std::move(tracked));
+    }
+
+    // A tracked frame is always delivered, even when cancelled meanwhile,
+    // so the engine's frame index never lags the trackers' state
+    flushScoring(session, cancel);
+}
+
+int TrackingWorker::pyramidLevel(const TrackingOptions& options, const QRectF& rect)
+{
+    if (options.scale != TrackingOptions::kAutoScale) {
+        int level = 0;
+        while ((2 << level) <= options.scale && level + 1 < kPyramidLevels)
+            ++level;
+        return level;
+    }
+
+    // Largest downscale that still leaves the box enough detail
+    double side = std::min(rect.width(), rect.height());
+    int level = 0;
+    while (level + 1 < kPyramidLevels && side / (2 << level) >= kMinAutoSide)
+        ++level;
+    return level;
+}
+
+void TrackingWorker::requireFeatures()
+{
+    // Only what the current trackers use is built for each frame
+    m_features.clearRequirements();
+    for (const auto& inst : m_trackers)
+        m_features.require(inst.level, inst.input);
+}
+
+const cv::Mat& TrackingWorker::trackerImage(const TrackerInstance& inst) const
+{
+    return m_features.image(inst.level, inst.input);
+}
+
+BoundingBox TrackingWorker::updateTracker(TrackerInstance& inst, const cv::Mat& frame)
+{
+    cv::Rect roi;
+    int64 start = cv::getTickCount();
+    bool ok = inst.tracker->update(frame, roi);
+    recordCost(inst, cv::getTickCount() - start);
+    return acceptUpdate(inst, ok, roi);
+}
+
+BoundingBox TrackingWorker::acceptUpdate(TrackerInstance& inst, bool ok, const cv::Rect& roi)
+{
+    if (ok) {
+        // Back to full-resolution video coordinates
+        int s = 1 << inst.level;
+        inst.box.rect = QRectF(roi.x * s, roi.y * s, roi.width * s, roi.height * s);
+        inst.box.confidence = 1.0;
+        QPointF center = inst.box.rect.center();
+        if (inst.span > 0)
+            inst.velocity = (center - inst.updatedCenter) / inst.span;
+        inst.updatedCenter = center;
+    } else {
+        // Tracker lost - keep last known position but lower confidence
+        inst.box.confidence = 0.0;
+        inst.velocity = QPointF();
+    }
+    inst.span = 0;
+    return inst.box;
+}
+
+void TrackingWorker::recordCost(TrackerInstance& inst, int64 ticks)
+{
+    inst.updateTicks += ticks;
+    ++inst.updates;
+    double seconds = ticks / cv::getTickFrequency();
+    inst.cost = inst.cost > 0.0 ? inst.cost + kCostSmoothing * (seconds - inst.cost) : seconds;
+}
+
+void TrackingWorker::schedule()
+{
+    std::vector<bool>& due = m_due;
+    due.assign(m_trackers.size(), true);
+    if (m_options.fpsBudget <= 0)
+        return;
+
+    // Hard boxes are always due. The rest are ranked by how far they are
+    // expected to have drifted since their last update and taken while the
+    // step's time budget lasts.
+    double remaining = 1.0 / m_options.fpsBudget;
+    auto& candidates = m_candidates;
+    candidates.clear();
+    for (size_t i = 0; i < m_trackers.size(); ++i) {
+        const TrackerInstance& inst = m_trackers[i];
+        double size = std::sqrt(std::max(1.0, inst.box.rect.width() * inst.box.rect.height()));
+        double motion = std::hypot(inst.velocity.x(), inst.velocity.y()) / size;
+        if (inst.cost <= 0.0 || inst.box.confidence < kLowConfidence ||
+            motion >= kFastMotion || inst.span >= kMaxSkipFrames) {
+            remaining -= inst.cost;
+            continue;
+        }
+        due[i] = false;
+        candidates.emplace_back(motion * inst.span + 1.0 - inst.box.confidence, i);
+    }
+
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [](const auto& a, const auto& b) { return a.first > b.first; });
+    for (const auto& candidate : candidates) {
+        double cost = m_trackers[candidate.second].cost;
+        if (cost > remaining)
+            continue;
+        due[candidate.second] = true;
+        remaining -= cost;
+    }
+}
+
+void TrackingWorker::updateBatches(std::vector<BoundingBox>& boxes,
+                                   const std::vector<bool>& due)
+{
+    // Every due native filter of a pyramid level moves in one call; its
+    // time is split evenly over those targets
+    for (int level = 0; level < kPyramidLevels; ++level) {
+        std::vector<size_t>& members = m_batchMembers;
+        std::vector<int>& ids = m_batchIds;
+        members.clear();
+        ids.clear();
+        for (size_t i = 0; i < m_trackers.size(); ++i) {
+            if (due[i] && m_trackers[i].batchId >= 0 && m_trackers[i].level == level) {
+                members.push_back(i);
+                ids.push_back(m_trackers[i].batchId);
+            }
+        }
+        if (members.empty())
+            continue;
+
+        CorrelationTracker& batch = m_batches[level];
+        int64 start = cv::getTickCount();
+        batch.update(m_features.image(level, TrackerInput::Gray), ids);
+        int64 ticks = cv::getTickCount() - start;
+
+        for (size_t i : members) {
+            TrackerInstance& inst = m_trackers[i];
+            recordCost(inst, ticks / static_cast<int64>(members.size()));
+            boxes[i] = acceptUpdate(inst, batch.found(inst.batchId), batch.box(inst.batchId));
+        }
+    }
+}
+
+cv::Mat TrackingWorker::readFrame(int index)
+{
+    cv::Mat frame;
+    if (m_cache && m_cache->lookup(index, frame))
+        return frame;
+
+    if (m_direction > 0) {
+        frame = m_decoder.frameAt(index);
+    } else {
+        // Backwards, each GOP is decoded once in a forward pass and then
+        // served frame by frame from the end
+        if (!m_reverse.contains(index))
+            m_reverse.fill(m_decoder, m_keyframes.get(), index);
+        frame = m_reverse.frame(index);
+    }
+    if (m_cache && !frame.empty())
+        m_cache->insert(index, frame);
+    return frame;
+}
+
+void TrackingWorker::deliver(unsigned session, const CancelToken& cancel,
+                             TrackedFrame&& tracked)
+{
+    waitForDelivery(cancel);
+    ++m_inFlight;
+    ++m_tracked;
+
+    // The boxes move into the record that the engine, the session and the
+    // view all share from here on
+    auto annotation = std::make_shared<FrameAnnotation>();
+    annotation->frameIndex = tracked.frameIndex;
+    annotation->boxes = std::move(tracked.boxes);
+    emit frameTracked(session, FrameAnnotationPtr(std::move(annotation)), tracked.frame);
+}
+
+void TrackingWorker::reportSpeed(unsigned session)
+{
+    static constexpr double kReportInterval = 0.5; // seconds
+
+    int64 now = cv::getTickCount();
+    if ((now - m_lastSpeedReport) / cv::getTickFrequency() < kReportInterval)
+        return;
+    m_lastSpeedReport = now;
+
+    // Per-object update rate of each backend in use
+    std::vector<BackendSpeed> speeds;
+    for (const auto& backend : TrackerFactory::backends()) {
+        int64 ticks = 0;
+        int   updates = 0;
+        for (auto& inst : m_trackers) {
+            if (inst.backend != backend) continue;
+            ticks += inst.updateTicks;
+            updates += inst.updates;
+            inst.updateTicks = 0;
+            inst.updates = 0;
+        }
+        if (updates > 0 && ticks > 0) {
+            BackendSpeed speed;
+            speed.backend = backend;
+            speed.fps = updates * cv::getTickFrequency() / ticks;
+            speeds.push_back(speed);
+        }
+    }
+    if (!speeds.empty())
+        emit speedMeasured(session, speeds);
+}
+
+StageStats TrackingWorker::trackStats() const
+{
+    StageStats stats;
+    stats.processed = m_tracked;
+    stats.depth = m_inFlight;
+    stats.capacity = kMaxInFlight;
+    return stats;
+}
+
+void TrackingWorker::waitForDelivery(const CancelToken& cancel)
+{
+    // Backpressure: do not run ahead of what the GUI thread has consumed
+    QMutexLocker lock(&m_deliveryMutex);
+    while (m_inFlight >= kMaxInFlight && !*cancel)
+        m_deliveryDone.wait(&m_deliveryMutex);
+}
+
+void TrackingWorker::frameDelivered()
+{
+    QMutexLocker lock(&m_deliveryMutex);
+    --m_inFlight;
+    m_deliveryDone.wakeAll();
+}
+
+void TrackingWorker::wakeDelivery()
+{
+    QMutexLocker lock(&m_deliveryMutex);
+    m_deliveryDone.wakeAll();
+}
+
+void TrackingWorker::queueForScoring(unsigned session, const CancelToken& cancel,
+                                     TrackedFrame&& tracked)
+{
+    // Windows end on a tracked frame, never an interpolated one, so both
+    // ends of the verification pass have an image
+    m_window.push_back(std::move(tracked));
+    if (static_cast<int>(m_window.size()) < kScoringWindow || m_window.back().frame.empty())
+        return;
+
+    // Only one window is verified at a time, so results trail tracking by
+    // at most two windows
+    collectScores(session, cancel);
+
+    std::vector<TrackedFrame> frames;
+    frames.reserve(m_window.size() + 1);
+    frames.push_back(m_anchor);
+    frames.insert(frames.end(), m_window.begin(), m_window.end());
+
+    std::vector<TrackerBackend> backends;
+    std::vector<int> levels;
+    for (const auto& inst : m_trackers) {
+        backends.push_back(inst.backend);
+        levels.push_back(inst.level);
+    }
+
+    m_scores = std::async(std::launch::async, &TrackingWorker::verifyWindow,
+                          std::move(frames), std::move(backends), std::move(levels));
+    m_anchor = m_window.back();
+    m_scoring = std::move(m_window);
+    m_window.clear();
+}
+
+void TrackingWorker::collectScores(unsigned session, const CancelToken& cancel)
+{
+    if (!m_scores.valid())
+        return;
+
+    std::vector<std::vector<double>> scores = m_scores.get();
+    for (size_t f = 0; f < m_scoring.size(); ++f) {
+        auto& boxes = m_scoring[f].boxes;
+        for (size_t i = 0; i < boxes.size() && i < scores[f].size(); ++i)
+            boxes[i].confidence = std::min(boxes[i].confidence, scores[f][i]);
+        deliver(session, cancel, std::move(m_scoring[f]));
+    }
+    m_scoring.clear();
+}
+
+void TrackingWorker::flushScoring(unsigned session, const CancelToken& cancel)
+{
+    collectScores(session, cancel);
+
+    // A partial window is delivered unverified, with the trackers' own flags.
+    // Its last frame anchors the next window if the run is resumed.
+    if (!m_window.empty())
+        m_anchor = m_window.back();
+    for (auto& tracked : m_window)
+        deliver(session, cancel, std::move(tracked));
+    m_window.clear();
+}
+
+std::vector<std::vector<double>> TrackingWorker::verifyWindow(
+    std::vector<TrackedFrame> frames, std::vector<TrackerBackend> backends,
+    std::vector<int> levels)
+{
+    // frames[0] is the anchor, the rest the window in tracking order. Fresh
+    // trackers start from the window's last boxes and run back to the
+    // anchor; each frame is scored by how far the backward box lands from
+    // the forward one.
+    const size_t last = frames.size() - 1;
+    const size_t count = backends.size();
+    std::vector<std::vector<double>> scores(last, std::vector<double>(count, 0.0));
+
+    // Each frame is preprocessed once and shared by all trackers
+    std::vector<FrameFeatures> features(frames.size());
+    for (size_t f = 0; f < frames.size(); ++f) {
+        for (size_t i = 0; i < count; ++i)
+            features[f].require(levels[i], TrackerFactory::input(backends[i]));
+        features[f].build(frames[f].frame);
+    }
+
+    cv::parallel_for_(cv::Range(0, static_cast<int>(count)), [&](const cv::Range& range) {
+        for (int i = range.start; i < range.end; ++i) {
+            int level = levels[i];
+            TrackerInput input = TrackerFactory::input(backends[i]);
+            cv::Ptr<cv::Tracker> tracker = TrackerFactory::create(backends[i]);
+            tracker->init(features[last].image(level, input),
+                          scaledRoi(frames[last].boxes[i].rect, level));
+
+            double anchorDrift = -1.0; // stays negative if the tracker is lost
+            double nextScore = 0.0;
+            for (size_t f = last; f-- > 0;) {
+                // Interpolated frames share the score of the tracked frame
+                // that ends their stride
+                if (frames[f].frame.empty()) {
+                    scores[f - 1][i] = nextScore;
+                    continue;
+                }
+                cv::Rect roi;
+                if (!tracker->update(features[f].image(level, input), roi))
+                    break;
+                int s = 1 << level;
+                QRectF backward(roi.x * s, roi.y * s, roi.width * s, roi.height * s);
+                double drift = roundTripDrift(frames[f].boxes[i].rect, backward);
+                if (f == 0) {
+                    anchorDrift = drift;
+                } else {
+                    scores[f - 1][i] = driftConfidence(drift);
+                    nextScore = scores[f - 1][i];
+                }
+            }
+
+            // The frame the backward pass starts on cannot drift from itself,
+            // so it takes the full round trip to the anchor
+            if (anchorDrift >= 0.0)
+                scores[last - 1][i] = driftConfidence(anchorDrift);
+
+            // The interpolated frames of the last stride end on that frame,
+            // whose score was not known yet when the loop passed them
+            for (size_t f = last - 1; f > 0 && frames[f].frame.empty(); --f)
+                scores[f - 1][i] = scores[last - 1][i];
+        }
+    });
+    return scores;
+}
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QWaitCondition>
+#include <opencv2/core.hpp>
+#include <opencv2/tracking.hpp>
+#include <atomic>
+#include <future>
+#include <memory>
+#include <vector>
+#include "AnnotationData.h"
+#include "CorrelationTracker.h"
+#include "FrameDecoder.h"
+#include "FrameFeatures.h"
+#include "ReverseBuffer.h"
+#include "TrackerFactory.h"
+
+class FrameCache;
+class KeyframeIndex;
+
+// Per-run cancellation flag shared between TrackingEngine and its worker
+using CancelToken = std::shared_ptr<std::atomic<bool>>;
+
+struct TrackingOptions {
+    static constexpr int kAutoScale = 0;
+
+    // Downscale divisor the trackers run at (1, 2 or 4), or kAutoScale to
+    // pick one per box from its size
+    int scale = kAutoScale;
+
+    // Also track backwards from the initial frame, on a second worker
+    bool bidirectional = false;
+
+    // Score boxes by forward-backward round-trip drift instead of the
+    // trackers' binary success flag
+    bool consistencyScoring = false;
+
+    // Trackers update every stride-th frame; boxes in between are
+    // interpolated and delivered without a frame
+    int stride = 1;
+
+    // Forward tracking ends on this frame; -1 runs to the end of the video
+    int stopFrame = -1;
+
+    // Tracker updates per second to stay within; 0 updates every tracker on
+    // every step. Under a budget, stable boxes are updated less often and
+    // extrapolated in between, at a confidence below 1.
+    int fpsBudget = 0;
+};
+
+// Owns the trackers of one tracking direction and runs them on its own
+// thread. Frames come from the shared frame cache or the worker's own
+// decoder, so tracking never waits on the GUI thread. Everything except
+// frameDelivered() and wakeDelivery() runs on the worker thread.
+class TrackingWorker : public QObject {
+    Q_OBJECT
+public:
+    struct Source {
+        QString                              path;
+        std::shared_ptr<const KeyframeIndex> keyframes;
+        std::shared_ptr<FrameCache>          cache;
+    };
+
+    explicit TrackingWorker(QObject* parent = nullptr);
+
+    // backends holds one entry per box; direction is +1 or -1
+    void initialize(const Source& source, const TrackingOptions& options,
+                    int direction, const cv::Mat& frame, int frameIndex,
+                    const std::vector<BoundingBox>& initialBoxes,
+                    const std::vector<TrackerBackend>& backends, unsigned session);
+    void run(unsigned session, CancelToken cancel);
+    void clear();
+
+    // Restarts the trackers on an earlier (or corrected) state without
+    // touching the rest of the session. Boxes are matched to trackers by
+    // trackId; trackers without a box are dropped, new trackIds get one.
+    void rewind(int frameIndex, const std::vector<BoundingBox>& boxes, unsigned session);
+
+    // Called by the engine on the GUI thread for every result it receives
+    void frameDelivered();
+
+    // Wakes a run() blocked on delivery so it sees its cancel token set
+    void wakeDelivery();
+
+    // Safe to call from any thread
+    StageStats decodeStats() const { return m_decoder.stats(); }
+    StageStats trackStats() const;
+
+signals:
+    void frameTracked(unsigned session, const FrameAnnotationPtr& annotation,
+                      const cv::Mat& frame);
+    void speedMeasured(unsigned session, const std::vector<BackendSpeed>& speeds);
+    void finished(unsigned session);
+    void error(unsigned session, const QString& message);
+
+private:
+    struct TrackerInstance {
+        cv::Ptr<cv::Tracker> tracker;         // null for batched backends
+        int                  batchId = -1;    // target in m_batches[level]
+        TrackerBackend       backend = TrackerBackend::KCF;
+        TrackerInput         input = TrackerInput::Color;
+        BoundingBox          box;
+        int                  level = 0;       // pyramid level, scale = 1 << level
+        int64                updateTicks = 0; // since the last speed report
+        int                  updates = 0;
+        double               cost = 0.0;      // seconds per update, smoothed
+        QPointF              velocity;        // pixels per frame between updates
+        QPointF              updatedCenter;   // box center at the last update
+        int                  span = 0;        // frames since the last update
+    };
+
+    struct TrackedFrame {
+        int                      frameIndex = 0;
+        std::vector<BoundingBox> boxes;
+        cv::Mat                  frame;
+    };
+
+    static int         pyramidLevel(const TrackingOptions& options, const QRectF& rect);
+    static BoundingBox updateTracker(TrackerInstance& inst, const cv::Mat& frame);
+    static BoundingBox acceptUpdate(TrackerInstance& inst, bool ok, const cv::Rect& roi);
+    static void        recordCost(TrackerInstance& inst, int64 ticks);
+    void    updateBatches(std::vector<BoundingBox>& boxes, const std::vector<bool>& due);
+    void    schedule(); // fills m_due
+    static bool        strideTooLarge(const std::vector<BoundingBox>& before,
+                                      const std::vector<BoundingBox>& after);
+    void    initTracker(TrackerInstance& inst, const BoundingBox& box);
+    void    setStride(int stride);
+    void    requireFeatures();
+    const cv::Mat& trackerImage(const TrackerInstance& inst) const;
+    cv::Mat readFrame(int index);
+    void    deliver(unsigned session, const CancelToken& cancel, TrackedFrame&& tracked);
+    void    waitForDelivery(const CancelToken& cancel);
+    void    reportSpeed(unsigned session);
+
+    // Forward-backward scoring, one window behind the tracking position
+    void    queueForScoring(unsigned session, const CancelToken& cancel,
+                            TrackedFrame&& tracked);
+    void    collectScores(unsigned session, const CancelToken& cancel);
+    void    flushScoring(unsigned session, const CancelToken& cancel);
+    static std::vector<std::vector<double>> verifyWindow(
+        std::vector<TrackedFrame> frames, std::vector<TrackerBackend> backends,
+        std::vector<int> levels);
+
+    // Results queued towards the GUI thread; each one holds a frame
+    static constexpr int kMaxInFlight = 4;
+
+    // Frames per forward-backward verification window
+    static constexpr int kScoringWindow = 10;
+
+    // Box movement per strided update, relative to box size, beyond which
+    // the step is retracked frame by frame
+    static constexpr double kMaxStrideDisplacement = 0.5;
+
+    static constexpr int kPyramidLevels = FrameFeatures::kLevels;
+
+    // Under an fps budget, boxes below this confidence, moving faster than
+    // this (box sizes per frame) or left alone this long are always updated
+    static constexpr double kLowConfidence = 0.5;
+    static constexpr double kFastMotion = 0.02;
+    static constexpr int    kMaxSkipFrames = 8;
+
+    TrackingOptions              m_options;
+    int                          m_direction = 1;
+    std::vector<TrackerInstance> m_trackers;
+    CorrelationTracker           m_batches[kPyramidLevels]; // BatchMOSSE targets
+    FrameFeatures                m_features; // of the frame being tracked
+    FrameDecoder                 m_decoder;
+    ReverseBuffer                m_reverse;
+    QString                      m_path;
+    std::shared_ptr<FrameCache>  m_cache;
+    std::shared_ptr<const KeyframeIndex> m_keyframes;
+
+    TrackedFrame                 m_anchor;   // frame preceding m_window
+    std::vector<TrackedFrame>    m_window;   // tracked, waiting for a full window
+    std::vector<TrackedFrame>    m_scoring;  // under verification
+    std::future<std::vector<std::vector<double>>> m_scores;
+    std::atomic<int>             m_inFlight{0};
+    QMutex                       m_deliveryMutex;
+    QWaitCondition               m_deliveryDone; // engine -> worker
+    std::atomic<unsigned long long> m_tracked{0};
+    int                          m_trackingFrameIndex = 0;
+    cv::Mat                      m_trackingFrame;      // frame of m_trackingFrameIndex
+    int                          m_stride = 1;         // currently in effect
+    int                          m_recoveryFrames = 0; // left at stride 1 after a fallback
+    int64                        m_lastSpeedReport = 0;
+
+    // Scratch of run(), schedule() and updateBatches()
+    std::vector<BoundingBox>     m_previousBoxes;
+    std::vector<bool>            m_due;
+    std::vector<std::pair<double, size_t>> m_candidates;
+    std::vector<size_t>          m_batchMembers;
+    std::vector<int>             m_batchIds;
+};
@@ -1,9 +1,22 @@
 #include "VideoManager.h"
 #include "AnnotationData.h"
 #include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cstdlib>
+
+// Backward requests at most this far behind the current frame are treated as
+// stepping and served from the reverse buffer
+static constexpr int kMaxBackwardStep = 8;
+
+static constexpr size_t kProxyCacheBudget = size_t(256) << 20;
+
+// Cached frames further than this from a scrub target are not worth showing
+static constexpr int kMaxPreviewDistance = 250;
 
 VideoManager::VideoManager(QObject* parent)
     : QObject(parent)
+    , m_cache(std::make_shared<FrameCache>())
+    , m_proxyCache(kProxyCacheBudget)
 {
 }
 
@@ -16,17 +29,20 @@ bool VideoManager::openVideo(const QString& path)
 {
     closeVideo();
 
-    if (!m_capture.open(path.toStdString()))
+    // Decoding runs ahead on the decoder's worker thread from here on
+    if (!m_decoder.open(path))
         return false;
 
     m_filePath = path;
-    m_totalFrames = static_cast<int>(m_capture.get(cv::CAP_PROP_FRAME_COUNT));
-    m_fps = m_capture.get(cv::CAP_PROP_FPS);
-    if (m_fps <= 0) m_fps = 30.0;
+    m_totalFrames = m_decoder.totalFrames();
+    m_fps = m_decoder.fps();
+    m_frameSize = m_decoder.frameSize();
 
-    int w = static_cast<int>(m_capture.get(cv::CAP_PROP_FRAME_WIDTH));
-    int h = static_cast<int>(m_capture.get(cv::CAP_PROP_FRAME_HEIGHT));
-    m_frameSize = QSize(w, h);
+    // A matching sidecar makes the index usable at once; otherwise seeks use
+    // the backend's CAP_PROP_POS_FRAMES handling until the scan finishes
+    m_keyframes = std::make_shared<KeyframeIndex>();
+    m_keyframes->loadOrBuild(path, m_totalFrames);
+    m_decoder.setKeyframeIndex(m_keyframes);
 
     // Read the first frame
     getFrame(0);
@@ -37,10 +53,18 @@ bool VideoManager::openVideo(const QString& path)
 
 void VideoManager::closeVideo()
 {
-    if (m_capture.isOpened()) {
-        m_capture.release();
+    if (m_decoder.isOpened()) {
+        m_decoder.close();
+        m_keyframes->cancel();
+        m_keyframes.reset();
+        m_cache->clear();
+        m_cache->resetStats();
+        m_reverse.clear();
+        m_proxyCache.clear();
         m_currentFrame = cv::Mat();
         m_currentIndex = -1;
+        m_requestedIndex = -1;
+        m_pendingIndex = -1;
         m_totalFrames = 0;
         m_filePath.clear();
         emit videoClosed();
@@ -49,31 +73,214 @@ void VideoManager::closeVideo()
 
 bool VideoManager::isOpened() const
 {
-    return m_capture.isOpened();
+    return m_decoder.isOpened();
 }
 
 cv::Mat VideoManager::getFrame(int index)
 {
-    if (!m_capture.isOpened() || index < 0 || index >= m_totalFrames)
+    if (!m_decoder.isOpened() || index < 0 || index >= m_totalFrames)
         return cv::Mat();
 
-    // Only seek if not the next consecutive frame
-    if (index != m_currentIndex + 1) {
-        m_capture.set(cv::CAP_PROP_POS_FRAMES, index);
+    // Supersedes any pending asynchronous request
+    ++m_requestSerial;
+    m_requestedIndex = -1;
+    m_pendingIndex = -1;
+
+    cv::Mat frame = decodeFrame(index);
+    if (!frame.empty()) {
+        m_currentFrame = frame;
+        m_currentIndex = index;
     }
+    return m_currentFrame;
+}
+
+cv::Mat VideoManager::peekFrame(int index)
+{
+    if (!m_decoder.isOpened() || index < 0 || index >= m_totalFrames)
+        return cv::Mat();
+
+    cv::Mat frame;
+    if (m_reverse.contains(index))
+        return m_reverse.frame(index);
+    if (m_cache->lookup(index, frame))
+        return frame;
+
+    frame = m_decoder.frameAt(index);
+    m_cache->insert(index, frame);
+
+    // The blocking read took the decoder over from a pending request; hand
+    // it back so its frameReady still follows
+    if (m_pendingIndex >= 0)
+        submitRequest(m_requestSerial, m_pendingProxy, m_pendingIndex);
+    return frame;
+}
 
+void VideoManager::setCurrentFrame(int index, const cv::Mat& frame)
+{
+    if (frame.empty())
+        return;
+    m_currentFrame = frame;
+    m_currentIndex = index;
+}
+
+cv::Mat VideoManager::settleRequestedFrame()
+{
+    if (m_requestedIndex >= 0 &&
+        (m_pendingIndex >= 0 || m_requestedIndex != m_currentIndex))
+        getFrame(m_requestedIndex);
+    m_requestedIndex = -1;
+    return m_currentFrame;
+}
+
+cv::Mat VideoManager::requestFrame(int index, bool proxy, int* shownIndex)
+{
+    if (!m_decoder.isOpened() || index < 0 || index >= m_totalFrames)
+        return cv::Mat();
+
+    unsigned serial = ++m_requestSerial;
+    proxy = proxy && m_proxyScale > 1;
+    m_requestedIndex = index;
+    m_pendingIndex = -1;
+
+    // Exact hits are answered synchronously
     cv::Mat frame;
-    if (m_capture.read(frame)) {
+    bool hit = (proxy && m_proxyCache.lookup(index, frame));
+    if (!hit && m_reverse.contains(index)) {
+        frame = m_reverse.frame(index);
+        hit = true;
+    }
+    if (!hit)
+        hit = m_cache->lookup(index, frame);
+    if (hit) {
+        if (!proxy || frame.cols == m_frameSize.width()) {
+            m_currentFrame = frame;
+            m_currentIndex = index;
+        }
+        if (shownIndex) *shownIndex = index;
+        return frame;
+    }
+
+    // Show the nearest frame we have while the exact one is decoded
+    int     found = -1, proxyFound = -1;
+    cv::Mat proxyFrame;
+    bool    haveFull = m_cache->nearest(index, kMaxPreviewDistance, found, frame);
+    if (m_proxyCache.nearest(index, kMaxPreviewDistance, proxyFound, proxyFrame) &&
+        (!haveFull || std::abs(proxyFound - index) < std::abs(found - index))) {
+        found = proxyFound;
+        frame = proxyFrame;
+    }
+    if (shownIndex) *shownIndex = found;
+
+    m_pendingIndex = index;
+    m_pendingProxy = proxy;
+    submitRequest(serial, proxy, index);
+    return frame;
+}
+
+void VideoManager::submitRequest(unsigned serial, bool proxy, int index)
+{
+    m_decoder.requestFrame(index, [this, serial, proxy](int i, const cv::Mat& decoded) {
+        // Runs on the decoder thread; hand the frame over to ours
+        cv::Mat shared = decoded;
+        QMetaObject::invokeMethod(this, [this, serial, proxy, i, shared]() {
+            deliverRequestedFrame(serial, proxy, i, shared);
+        }, Qt::QueuedConnection);
+    });
+}
+
+void VideoManager::deliverRequestedFrame(unsigned serial, bool proxy, int index,
+                                         const cv::Mat& frame)
+{
+    if (serial != m_requestSerial)
+        return; // superseded while in flight
+    m_pendingIndex = -1;
+
+    m_cache->insert(index, frame);
+    if (!proxy) {
         m_currentFrame = frame;
         m_currentIndex = index;
+        emit frameReady(index, frame);
+        return;
+    }
+
+    cv::Mat small;
+    double f = 1.0 / m_proxyScale;
+    cv::resize(frame, small, cv::Size(), f, f, cv::INTER_AREA);
+    m_proxyCache.insert(index, small);
+    emit frameReady(index, small);
+}
+
+cv::Mat VideoManager::getProxyFrame(int index)
+{
+    if (m_proxyScale <= 1)
+        return getFrame(index);
+    if (!m_decoder.isOpened() || index < 0 || index >= m_totalFrames)
+        return cv::Mat();
+
+    // Proxies are small enough that a scrubbed range stays cached and
+    // repeated drags over it skip decoding altogether
+    cv::Mat proxy;
+    if (m_proxyCache.lookup(index, proxy))
+        return proxy;
+
+    cv::Mat frame = decodeFrame(index);
+    if (frame.empty())
+        return frame;
+
+    double f = 1.0 / m_proxyScale;
+    cv::resize(frame, proxy, cv::Size(), f, f, cv::INTER_AREA);
+    m_proxyCache.insert(index, proxy);
+    return proxy;
+}
+
+void VideoManager::setProxyScale(int divisor)
+{
+    divisor = std::max(1, divisor);
+    if (divisor != m_proxyScale) {
+        m_proxyScale = divisor;
+        m_proxyCache.clear();
+    }
+}
+
+cv::Mat VideoManager::decodeFrame(int index)
+{
+    // Cached frames skip the decoder entirely. Otherwise the frame comes from
+    // the read-ahead buffer; the decoder seeks on its own when the index is
+    // not ahead of what it has already decoded. Backward steps decode the
+    // GOP before the current frame once and walk back through it.
+    cv::Mat frame;
+    if (m_reverse.contains(index)) {
+        frame = m_reverse.frame(index);
+    } else if (!m_cache->lookup(index, frame)) {
+        bool backwardStep = index < m_currentIndex &&
+                            index >= m_currentIndex - kMaxBackwardStep;
+        if (backwardStep) {
+            m_reverse.fill(m_decoder, m_keyframes.get(), index);
+            frame = m_reverse.frame(index);
+        } else {
+            frame = m_decoder.frameAt(index);
+        }
+        m_cache->insert(index, frame);
+    }
+    return frame;
+}
+
+// Draws the boxes of one frame straight from the table's columns
+static void drawBoxes(cv::Mat& frame, const BoxTable& boxes, int frameIndex)
+{
+    const BoxTable::Columns& c = boxes.columns();
+    BoxTable::Rows rows = boxes.frameRows(frameIndex);
+    for (int row = rows.begin; row < rows.end; ++row) {
+        cv::Rect r(static_cast<int>(c.x[row]), static_cast<int>(c.y[row]),
+                   static_cast<int>(c.width[row]), static_cast<int>(c.height[row]));
+        cv::rectangle(frame, r, cv::Scalar(0, 255, 0), 2);
     }
-    return m_currentFrame;
 }
 
 bool VideoManager::writeSegmentVideo(const QString& outputPath,
                                       const ResultSegment& segment)
 {
-    if (!m_capture.isOpened())
+    if (!m_decoder.isOpened())
         return false;
 
     int fourcc = cv::VideoWriter::fourcc('m', 'p', '4', 'v');
@@ -83,22 +290,11 @@ bool VideoManager::writeSegmentVideo(const QString& outputPath,
         return false;
 
     for (int i = segment.startFrame; i <= segment.endFrame; ++i) {
-        cv::Mat frame = getFrame(i);
+        // Boxes are drawn onto a copy; the decoded frame stays in the buffer
+        cv::Mat frame = getFrame(i).clone();
         if (frame.empty()) break;
 
-        // Find annotation for this frame and draw boxes
-        for (const auto& fa : segment.annotations) {
-            if (fa.frameIndex == i) {
-                for (const auto& box : fa.boxes) {
-                    cv::Rect r(static_cast<int>(box.rect.x()),
-                               static_cast<int>(box.rect.y()),
-                               static_cast<int>(box.rect.width()),
-                               static_cast<int>(box.rect.height()));
-                    cv::rectangle(frame, r, cv::Scalar(0, 255, 0), 2);
-                }
-                break;
-            }
-        }
+        drawBoxes(frame, segment.boxes, i);
 
         writer.write(frame);
     }
@@ -110,7 +306,7 @@ bool VideoManager::writeSegmentVideo(const QString& outputPath,
 bool VideoManager::mergeSegments(const QString& outputPath,
                                   const std::vector<ResultSegment>& segments)
 {
-    if (!m_capture.isOpened() || segments.empty())
+    if (!m_decoder.isOpened() || segments.empty())
         return false;
 
     int fourcc = cv::VideoWriter::fourcc('m', 'p', '4', 'v');
@@ -121,21 +317,10 @@ bool VideoManager::mergeSegments(const QString& outputPath,
 
     for (const auto& seg : segments) {
         for (int i = seg.startFrame; i <= seg.endFrame; ++i) {
-            cv::Mat frame = getFrame(i);
+            cv::Mat frame = getFrame(i).clone();
             if (frame.empty()) continue;
 
-            for (const auto& fa : seg.annotations) {
-                if (fa.frameIndex == i) {
-                    for (const auto& box : fa.boxes) {
-                        cv::Rect r(static_cast<int>(box.rect.x()),
-                                   static_cast<int>(box.rect.y()),
-                                   static_cast<int>(box.rect.width()),
-                                   static_cast<int>(box.rect.height()));
-                        cv::rectangle(frame, r, cv::Scalar(0, 255, 0), 2);
-                    }
-                    break;
-                }
-            }
+            drawBoxes(frame, seg.boxes, i);
 
             writer.write(frame);
         }
@@ -3,9 +3,13 @@
 #include <QObject>
 #include <QSize>
 #include <QString>
-#include <opencv2/videoio.hpp>
 #include <opencv2/core.hpp>
+#include <memory>
 #include <vector>
+#include "FrameCache.h"
+#include "FrameDecoder.h"
+#include "KeyframeIndex.h"
+#include "ReverseBuffer.h"
 
 struct ResultSegment;
 
@@ -20,12 +24,43 @@ public:
     bool isOpened() const;
 
     cv::Mat getFrame(int index);
+
+    // Frame for a still image such as a thumbnail. Neither changes the
+    // current frame nor supersedes a pending requestFrame().
+    cv::Mat peekFrame(int index);
+
+    // Downscaled frame for scrubbing and playback. Does not change the
+    // current frame; box coordinates stay in full-resolution video space.
+    cv::Mat getProxyFrame(int index);
+    void setProxyScale(int divisor);
+    int  proxyScale() const { return m_proxyScale; }
+
+    // Latest-wins asynchronous request used while scrubbing. Returns the
+    // closest frame that is already cached (the exact one on a hit) so it can
+    // be shown at once; otherwise frameReady follows for the exact frame
+    // unless a newer request or a getFrame() call supersedes it.
+    cv::Mat requestFrame(int index, bool proxy, int* shownIndex = nullptr);
+
+    // Makes the frame of the latest requestFrame() current, decoding it now
+    // if it is still pending or only arrived as a proxy. Call before using
+    // the current frame for what the user sees, e.g. to start tracking.
+    cv::Mat settleRequestedFrame();
     cv::Mat currentFrame() const { return m_currentFrame; }
     int currentFrameIndex() const { return m_currentIndex; }
     int totalFrames() const { return m_totalFrames; }
     double fps() const { return m_fps; }
     QSize frameSize() const { return m_frameSize; }
     QString filePath() const { return m_filePath; }
+    std::shared_ptr<const KeyframeIndex> keyframeIndex() const { return m_keyframes; }
+
+    // Decoded-frame cache shared by scrubbing, playback and export
+    void setCacheBudget(size_t bytes) { m_cache->setBudget(bytes); }
+    FrameCache::Stats cacheStats() const { return m_cache->stats(); }
+    std::shared_ptr<FrameCache> frameCache() const { return m_cache; }
+
+    // Adopts a frame decoded elsewhere (e.g. by the tracking thread) as the
+    // current frame
+    void setCurrentFrame(int index, const cv::Mat& frame);
 
     // Write a result segment as a video file with bounding box overlays
     bool writeSegmentVideo(const QString& outputPath,
@@ -38,9 +73,24 @@ public:
 signals:
     void videoOpened(const QString& path);
     void videoClosed();
+    void frameReady(int index, const cv::Mat& frame);
 
 private:
-    cv::VideoCapture m_capture;
+    cv::Mat decodeFrame(int index);
+    void    submitRequest(unsigned serial, bool proxy, int index);
+    void    deliverRequestedFrame(unsigned serial, bool proxy, int index,
+                                  const cv::Mat& frame);
+
+    FrameDecoder     m_decoder;
+    std::shared_ptr<KeyframeIndex> m_keyframes;
+    std::shared_ptr<FrameCache> m_cache;
+    ReverseBuffer    m_reverse;
+    FrameCache       m_proxyCache;
+    int              m_proxyScale = 2;
+    unsigned         m_requestSerial = 0; // bumped by every frame request
+    int              m_requestedIndex = -1; // latest requestFrame() target
+    int              m_pendingIndex = -1; // requestFrame() awaiting the decoder
+    bool             m_pendingProxy = false;
     cv::Mat          m_currentFrame;
     int              m_currentIndex = -1;
     int              m_totalFrames = 0;
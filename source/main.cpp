@@ -1,4 +1,7 @@
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
+#include "core/ProjectBenchmark.h"
 #include "ui/MainWindow.h"
 
 int main(int argc, char *argv[])
@@ -7,6 +10,22 @@ int main(int argc, char *argv[])
     app.setApplicationName("GT_labler");
     app.setApplicationVersion("1.0");
 
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption benchmarkOption(
+        "benchmark-load",
+        QCoreApplication::translate("main", "Time opening [project] (or a synthetic one) "
+                                            "against parsing its boxes as MOT text, then exit."));
+    parser.addOption(benchmarkOption);
+    parser.addPositionalArgument("project",
+                                 QCoreApplication::translate("main", "Project file to benchmark."),
+                                 "[project]");
+    parser.process(app);
+    if (parser.isSet(benchmarkOption)) {
+        QTextStream(stdout) << ProjectBenchmark::run(parser.positionalArguments().value(0));
+        return 0;
+    }
+
     MainWindow window;
     window.setWindowTitle("Ground Truth Labler");
     window.resize(1280, 720);
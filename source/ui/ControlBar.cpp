@@ -1,9 +1,13 @@
 #include "ControlBar.h"
+#include "CoverageBar.h"
 #include <QHBoxLayout>
 #include <QVBoxLayout>
 #include <QPushButton>
 #include <QSlider>
 #include <QLabel>
+#include <QComboBox>
+#include <QCheckBox>
+#include <QSpinBox>
 
 ControlBar::ControlBar(QWidget* parent)
     : QWidget(parent)
@@ -15,12 +19,63 @@ ControlBar::ControlBar(QWidget* parent)
     m_frameLabel = new QLabel("Frame: 0 / 0");
     m_frameSlider = new QSlider(Qt::Horizontal);
     m_frameSlider->setEnabled(false);
-    sliderLayout->addWidget(m_frameSlider, 1);
+    m_coverageBar = new CoverageBar;
+    auto* timelineLayout = new QVBoxLayout;
+    timelineLayout->setSpacing(1);
+    timelineLayout->addWidget(m_frameSlider);
+    timelineLayout->addWidget(m_coverageBar);
+    sliderLayout->addLayout(timelineLayout, 1);
     sliderLayout->addWidget(m_frameLabel);
     mainLayout->addLayout(sliderLayout);
 
     // Buttons row
     auto* btnLayout = new QHBoxLayout;
+
+    // Tracker selection: named profiles first, then every backend
+    m_trackerCombo = new QComboBox;
+    for (const auto& profile : TrackerFactory::profiles()) {
+        m_trackerCombo->addItem(QString("%1 (%2)").arg(profile.name, TrackerFactory::name(profile.backend)),
+                                static_cast<int>(profile.backend));
+    }
+    m_trackerCombo->insertSeparator(m_trackerCombo->count());
+    for (auto backend : TrackerFactory::backends())
+        m_trackerCombo->addItem(TrackerFactory::name(backend), static_cast<int>(backend));
+    m_trackerCombo->setCurrentIndex(1); // Balanced
+    m_scaleCombo = new QComboBox;
+    m_scaleCombo->addItem(tr("Auto"), 0);
+    m_scaleCombo->addItem(tr("Full"), 1);
+    m_scaleCombo->addItem(tr("1/2"), 2);
+    m_scaleCombo->addItem(tr("1/4"), 4);
+    m_scaleCombo->setToolTip(tr("Resolution the trackers run at. Auto picks it per box from the box size."));
+    m_strideSpin = new QSpinBox;
+    m_strideSpin->setRange(1, 16);
+    m_strideSpin->setToolTip(tr("Update the trackers every Nth frame and interpolate in between. "
+                                "Fast motion falls back to every frame."));
+    m_budgetSpin = new QSpinBox;
+    m_budgetSpin->setRange(0, 240);
+    m_budgetSpin->setSingleStep(5);
+    m_budgetSpin->setSuffix(tr(" fps"));
+    m_budgetSpin->setSpecialValueText(tr("Off"));
+    m_budgetSpin->setToolTip(tr("Tracking speed to aim for. Fast-moving and uncertain boxes are "
+                                "updated every frame, stable ones less often and extrapolated."));
+    m_bothDirectionsCheck = new QCheckBox(tr("Both directions"));
+    m_bothDirectionsCheck->setToolTip(tr("Also track backwards from the frame the boxes were drawn on."));
+    m_consistencyCheck = new QCheckBox(tr("FB score"));
+    m_consistencyCheck->setToolTip(tr("Score each box by forward-backward round-trip drift. "
+                                      "Results appear a few frames later."));
+    m_speedLabel = new QLabel;
+    m_speedLabel->setMinimumWidth(160);
+    btnLayout->addWidget(new QLabel(tr("Tracker:")));
+    btnLayout->addWidget(m_trackerCombo);
+    btnLayout->addWidget(new QLabel(tr("Scale:")));
+    btnLayout->addWidget(m_scaleCombo);
+    btnLayout->addWidget(new QLabel(tr("Stride:")));
+    btnLayout->addWidget(m_strideSpin);
+    btnLayout->addWidget(new QLabel(tr("Budget:")));
+    btnLayout->addWidget(m_budgetSpin);
+    btnLayout->addWidget(m_bothDirectionsCheck);
+    btnLayout->addWidget(m_consistencyCheck);
+    btnLayout->addWidget(m_speedLabel);
     btnLayout->addStretch();
 
     m_runBtn = new QPushButton(tr("Run"));
@@ -59,6 +114,9 @@ ControlBar::ControlBar(QWidget* parent)
         m_frameLabel->setText(QString("Frame: %1 / %2").arg(val).arg(m_frameSlider->maximum()));
         emit frameSliderChanged(val);
     });
+    connect(m_frameSlider, &QSlider::sliderReleased, this, [this]() {
+        emit frameSliderReleased(m_frameSlider->value());
+    });
 }
 
 void ControlBar::setRunEnabled(bool en) { m_runBtn->setEnabled(en); }
@@ -69,6 +127,7 @@ void ControlBar::setUndoEnabled(bool en) { m_undoBtn->setEnabled(en); }
 void ControlBar::setFrameRange(int min, int max)
 {
     m_frameSlider->setRange(min, max);
+    m_coverageBar->setFrameRange(min, max);
     m_frameLabel->setText(QString("Frame: %1 / %2").arg(m_frameSlider->value()).arg(max));
 }
 
@@ -80,7 +139,60 @@ void ControlBar::setCurrentFrame(int frame)
     m_frameLabel->setText(QString("Frame: %1 / %2").arg(frame).arg(m_frameSlider->maximum()));
 }
 
+void ControlBar::setCoverage(std::vector<SegmentIndex::Interval> intervals)
+{
+    m_coverageBar->setCoverage(std::move(intervals));
+}
+
 void ControlBar::setSliderEnabled(bool en)
 {
     m_frameSlider->setEnabled(en);
 }
+
+bool ControlBar::isSliderDragging() const
+{
+    return m_frameSlider->isSliderDown();
+}
+
+TrackerBackend ControlBar::selectedBackend() const
+{
+    return static_cast<TrackerBackend>(m_trackerCombo->currentData().toInt());
+}
+
+void ControlBar::setTrackerSpeeds(const std::vector<BackendSpeed>& speeds)
+{
+    for (const auto& speed : speeds)
+        m_speeds[static_cast<int>(speed.backend)] = speed.fps;
+
+    QStringList parts;
+    for (auto it = m_speeds.constBegin(); it != m_speeds.constEnd(); ++it) {
+        parts << QString("%1 %2 fps").arg(TrackerFactory::name(static_cast<TrackerBackend>(it.key())))
+                                     .arg(it.value(), 0, 'f', 0);
+    }
+    m_speedLabel->setText(parts.join("  "));
+}
+
+int ControlBar::trackingScale() const
+{
+    return m_scaleCombo->currentData().toInt();
+}
+
+bool ControlBar::trackBothDirections() const
+{
+    return m_bothDirectionsCheck->isChecked();
+}
+
+bool ControlBar::consistencyScoring() const
+{
+    return m_consistencyCheck->isChecked();
+}
+
+int ControlBar::trackingStride() const
+{
+    return m_strideSpin->value();
+}
+
+int ControlBar::fpsBudget() const
+{
+    return m_budgetSpin->value();
+}
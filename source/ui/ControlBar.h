@@ -1,10 +1,18 @@
 #pragma once
 
 #include <QWidget>
+#include <QMap>
+#include <vector>
+#include "core/SegmentIndex.h"
+#include "core/TrackerFactory.h"
 
 class QPushButton;
 class QSlider;
 class QLabel;
+class QComboBox;
+class QCheckBox;
+class QSpinBox;
+class CoverageBar;
 
 class ControlBar : public QWidget {
     Q_OBJECT
@@ -20,6 +28,28 @@ public:
     void setFrameRange(int min, int max);
     void setCurrentFrame(int frame);
     void setSliderEnabled(bool en);
+    bool isSliderDragging() const;
+
+    // Frames with accepted ground truth, drawn under the slider
+    void setCoverage(std::vector<SegmentIndex::Interval> intervals);
+
+    // Tracker selection. The readout keeps the latest measured speed of
+    // every backend used so far, for comparison.
+    TrackerBackend selectedBackend() const;
+    void setTrackerSpeeds(const std::vector<BackendSpeed>& speeds);
+
+    // Tracking resolution divisor, 0 = automatic per box
+    int trackingScale() const;
+
+    // Track backwards from the start frame too / score by round-trip drift
+    bool trackBothDirections() const;
+    bool consistencyScoring() const;
+
+    // Frames per tracker update; the ones in between are interpolated
+    int trackingStride() const;
+
+    // Tracker update rate to stay within, 0 = update every box every frame
+    int fpsBudget() const;
 
 signals:
     void runClicked();
@@ -27,6 +57,7 @@ signals:
     void acceptClicked();
     void undoClicked();
     void frameSliderChanged(int frame);
+    void frameSliderReleased(int frame);
 
 private:
     QPushButton* m_runBtn;
@@ -35,4 +66,13 @@ private:
     QPushButton* m_undoBtn;
     QSlider*     m_frameSlider;
     QLabel*      m_frameLabel;
+    CoverageBar* m_coverageBar;
+    QComboBox*   m_trackerCombo;
+    QComboBox*   m_scaleCombo;
+    QSpinBox*    m_strideSpin;
+    QSpinBox*    m_budgetSpin;
+    QCheckBox*   m_bothDirectionsCheck;
+    QCheckBox*   m_consistencyCheck;
+    QLabel*      m_speedLabel;
+    QMap<int, double> m_speeds; // backend -> fps
 };
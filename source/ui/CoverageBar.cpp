@@ -0,0 +1,43 @@
+#include "CoverageBar.h"
+#include <QPainter>
+#include <algorithm>
+
+CoverageBar::CoverageBar(QWidget* parent)
+    : QWidget(parent)
+{
+    setFixedHeight(6);
+    setToolTip(tr("Frames covered by accepted segments"));
+}
+
+void CoverageBar::setFrameRange(int min, int max)
+{
+    m_min = min;
+    m_max = max;
+    update();
+}
+
+void CoverageBar::setCoverage(std::vector<SegmentIndex::Interval> intervals)
+{
+    m_intervals = std::move(intervals);
+    update();
+}
+
+void CoverageBar::paintEvent(QPaintEvent*)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), palette().color(QPalette::Mid));
+    if (m_max <= m_min)
+        return;
+
+    // Intervals come from the segment index already merged, so a repaint
+    // costs one rectangle per covered run
+    const double scale = width() / static_cast<double>(m_max - m_min + 1);
+    const QColor single(76, 175, 80);
+    const QColor overlap(46, 125, 50);
+    for (const auto& interval : m_intervals) {
+        double x0 = (interval.first - m_min) * scale;
+        double x1 = (interval.last - m_min + 1) * scale;
+        painter.fillRect(QRectF(x0, 0, std::max(1.0, x1 - x0), height()),
+                         interval.count > 1 ? overlap : single);
+    }
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <QWidget>
+#include <vector>
+#include "core/SegmentIndex.h"
+
+// Strip under the frame slider showing which frames already have accepted
+// ground truth; overlapping segments are drawn darker
+class CoverageBar : public QWidget {
+    Q_OBJECT
+public:
+    explicit CoverageBar(QWidget* parent = nullptr);
+
+    void setFrameRange(int min, int max);
+    void setCoverage(std::vector<SegmentIndex::Interval> intervals);
+
+protected:
+    void paintEvent(QPaintEvent* event) override;
+
+private:
+    std::vector<SegmentIndex::Interval> m_intervals;
+    int                                 m_min = 0;
+    int                                 m_max = 0;
+};
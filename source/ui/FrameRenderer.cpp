@@ -0,0 +1,82 @@
+#include "FrameRenderer.h"
+#include "util/FrameConverter.h"
+#include <QMutexLocker>
+#include <QThread>
+
+FrameRenderer::FrameRenderer(QObject* parent)
+    : QObject(parent)
+{
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->start();
+}
+
+FrameRenderer::~FrameRenderer()
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        m_stopping = true;
+        m_wake.wakeAll();
+    }
+    m_thread->wait();
+    delete m_thread;
+}
+
+void FrameRenderer::submit(const FrameAnnotationPtr& annotation, const cv::Mat& frame)
+{
+    QMutexLocker lock(&m_mutex);
+    if (static_cast<int>(m_queue.size()) >= kCapacity) {
+        m_queue.pop_front();
+        ++m_dropped;
+    }
+    m_queue.push_back({annotation, frame});
+    m_wake.wakeAll();
+}
+
+void FrameRenderer::clear()
+{
+    QMutexLocker lock(&m_mutex);
+    m_dropped += m_queue.size();
+    m_queue.clear();
+}
+
+void FrameRenderer::frameDisplayed()
+{
+    QMutexLocker lock(&m_mutex);
+    if (m_inFlight > 0)
+        --m_inFlight;
+    m_wake.wakeAll();
+}
+
+StageStats FrameRenderer::stats() const
+{
+    QMutexLocker lock(&m_mutex);
+    StageStats stats;
+    stats.processed = m_rendered;
+    stats.dropped = m_dropped;
+    stats.depth = static_cast<int>(m_queue.size());
+    stats.capacity = kCapacity;
+    return stats;
+}
+
+void FrameRenderer::run()
+{
+    QMutexLocker lock(&m_mutex);
+    while (!m_stopping) {
+        // Waiting on the view leaves new frames to pile up and be dropped
+        if (m_queue.empty() || m_inFlight >= kMaxInFlight) {
+            m_wake.wait(&m_mutex);
+            continue;
+        }
+
+        Job job = std::move(m_queue.front());
+        m_queue.pop_front();
+        ++m_inFlight;
+        lock.unlock();
+
+        QImage image = FrameConverter::matToQImage(job.frame);
+        emit frameRendered(image, job.annotation);
+
+        lock.relock();
+        ++m_rendered;
+    }
+}
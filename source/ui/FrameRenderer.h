@@ -0,0 +1,55 @@
+#pragma once
+
+#include <QImage>
+#include <QMutex>
+#include <QObject>
+#include <QWaitCondition>
+#include <opencv2/core.hpp>
+#include <deque>
+#include <vector>
+#include "core/AnnotationData.h"
+#include "core/StageStats.h"
+
+class QThread;
+
+// Display stage of tracking: converts tracked frames to QImage on its own
+// thread. Only a couple of frames are queued; when the view falls behind the
+// oldest one is dropped, so tracking never waits on painting. Annotations
+// are stored before submit(), so dropping a frame loses nothing.
+class FrameRenderer : public QObject {
+    Q_OBJECT
+public:
+    explicit FrameRenderer(QObject* parent = nullptr);
+    ~FrameRenderer();
+
+    void submit(const FrameAnnotationPtr& annotation, const cv::Mat& frame);
+    void clear();
+
+    // Called by the view for every frameRendered() it has handled
+    void frameDisplayed();
+
+    StageStats stats() const;
+
+signals:
+    void frameRendered(const QImage& image, const FrameAnnotationPtr& annotation);
+
+private:
+    struct Job {
+        FrameAnnotationPtr annotation;
+        cv::Mat            frame;
+    };
+
+    void run();
+
+    static constexpr int kCapacity = 2;
+    static constexpr int kMaxInFlight = 1; // rendered, not yet shown
+
+    QThread*           m_thread = nullptr;
+    mutable QMutex     m_mutex;
+    QWaitCondition     m_wake;
+    std::deque<Job>    m_queue;
+    int                m_inFlight = 0;
+    bool               m_stopping = false;
+    unsigned long long m_rendered = 0;
+    unsigned long long m_dropped = 0;
+};
@@ -3,10 +3,15 @@
 #include "LabelPanel.h"
 #include "ResultPanel.h"
 #include "ControlBar.h"
+#include "FrameRenderer.h"
+#include "SessionPanel.h"
 #include "core/AnnotationData.h"
 #include "core/VideoManager.h"
 #include "core/TrackingEngine.h"
+#include "core/InterpolationEngine.h"
+#include "core/TrackingSession.h"
 #include "core/MotExporter.h"
+#include "core/ProjectFile.h"
 #include "util/FrameConverter.h"
 
 #include <QHBoxLayout>
@@ -14,9 +19,14 @@
 #include <QSplitter>
 #include <QMenuBar>
 #include <QFileDialog>
+#include <QFileInfo>
 #include <QMessageBox>
 #include <QKeyEvent>
 #include <QStatusBar>
+#include <QInputDialog>
+#include <QActionGroup>
+#include <QLabel>
+#include <algorithm>
 
 MainWindow::MainWindow(QWidget* parent)
     : QMainWindow(parent)
@@ -24,7 +34,12 @@ MainWindow::MainWindow(QWidget* parent)
     m_data = new AnnotationData(this);
     m_videoManager = new VideoManager(this);
     m_trackingEngine = new TrackingEngine(m_videoManager, this);
+    m_interpolator = new InterpolationEngine(this);
     m_playbackTimer = new QTimer(this);
+    m_reverseTimer = new QTimer(this);
+    m_renderer = new FrameRenderer(this);
+    m_statsTimer = new QTimer(this);
+    m_statsTimer->setInterval(500);
 
     setupLayout();
     setupMenuBar();
@@ -53,7 +68,12 @@ void MainWindow::setupLayout()
 
     // Right panel: results
     m_resultPanel = new ResultPanel(m_data);
-    splitter->addWidget(m_resultPanel);
+    m_sessionPanel = new SessionPanel;
+    auto* rightSplitter = new QSplitter(Qt::Vertical);
+    rightSplitter->addWidget(m_resultPanel);
+    rightSplitter->addWidget(m_sessionPanel);
+    rightSplitter->setStretchFactor(0, 1);
+    splitter->addWidget(rightSplitter);
 
     // Set stretch factors: left=0, center=1(stretch), right=0
     splitter->setStretchFactor(0, 0);
@@ -67,6 +87,9 @@ void MainWindow::setupLayout()
     mainLayout->addWidget(m_controlBar);
 
     setCentralWidget(centralWidget);
+
+    m_pipelineLabel = new QLabel;
+    statusBar()->addPermanentWidget(m_pipelineLabel);
 }
 
 void MainWindow::setupMenuBar()
@@ -77,6 +100,13 @@ void MainWindow::setupMenuBar()
     openAction->setShortcut(QKeySequence::Open);
     connect(openAction, &QAction::triggered, this, &MainWindow::onOpenVideo);
 
+    auto* openProjectAction = fileMenu->addAction(tr("Open &Project..."));
+    connect(openProjectAction, &QAction::triggered, this, &MainWindow::onOpenProject);
+
+    auto* saveProjectAction = fileMenu->addAction(tr("&Save Project..."));
+    saveProjectAction->setShortcut(QKeySequence::Save);
+    connect(saveProjectAction, &QAction::triggered, this, &MainWindow::onSaveProject);
+
     fileMenu->addSeparator();
 
     auto* exportMotAction = fileMenu->addAction(tr("Export &MOT CSV..."));
@@ -90,6 +120,92 @@ void MainWindow::setupMenuBar()
     auto* exitAction = fileMenu->addAction(tr("E&xit"));
     exitAction->setShortcut(QKeySequence::Quit);
     connect(exitAction, &QAction::triggered, this, &QWidget::close);
+
+    auto* trackingMenu = menuBar()->addMenu(tr("&Tracking"));
+    auto* backgroundAction = trackingMenu->addAction(tr("Track in &Background..."));
+    backgroundAction->setShortcut(QKeySequence(Qt::CTRL | Qt::Key_B));
+    connect(backgroundAction, &QAction::triggered, this, &MainWindow::onRunInBackground);
+
+    auto* rewindAction = trackingMenu->addAction(tr("&Rewind to Frame..."));
+    rewindAction->setShortcut(QKeySequence(Qt::CTRL | Qt::Key_R));
+    connect(rewindAction, &QAction::triggered, this, &MainWindow::onRewind);
+
+    auto* interpMenu = menuBar()->addMenu(tr("&Interpolation"));
+
+    auto* keyframeAction = interpMenu->addAction(tr("Set &Keyframe"));
+    keyframeAction->setShortcut(Qt::Key_K);
+    connect(keyframeAction, &QAction::triggered, this, &MainWindow::onSetKeyframe);
+
+    auto* interpolateAction = interpMenu->addAction(tr("&Fill Between Keyframes"));
+    interpolateAction->setShortcut(QKeySequence(Qt::CTRL | Qt::Key_I));
+    connect(interpolateAction, &QAction::triggered, this, &MainWindow::onInterpolate);
+
+    auto* clearKeyframesAction = interpMenu->addAction(tr("&Clear Keyframes"));
+    connect(clearKeyframesAction, &QAction::triggered, this, [this]() {
+        m_interpolator->clear();
+        m_keyframeTracks.clear();
+        statusBar()->showMessage(tr("Keyframes cleared."));
+    });
+
+    interpMenu->addSeparator();
+    auto* modelGroup = new QActionGroup(this);
+    for (auto model : { InterpolationModel::Linear, InterpolationModel::CubicSpline,
+                        InterpolationModel::ConstantVelocity }) {
+        auto* action = interpMenu->addAction(InterpolationEngine::modelName(model));
+        action->setCheckable(true);
+        action->setChecked(model == m_interpolator->model());
+        modelGroup->addAction(action);
+        connect(action, &QAction::triggered, this, [this, model]() {
+            m_interpolator->setModel(model);
+        });
+    }
+
+    auto* viewMenu = menuBar()->addMenu(tr("&View"));
+
+    // Proxy resolution used while scrubbing and playing segments back
+    auto* proxyMenu = viewMenu->addMenu(tr("&Proxy Resolution"));
+    auto* proxyGroup = new QActionGroup(this);
+    const std::pair<QString, int> proxyModes[] = {
+        { tr("&Full"), 1 }, { tr("&Half"), 2 }, { tr("&Quarter"), 4 }
+    };
+    for (const auto& mode : proxyModes) {
+        auto* action = proxyMenu->addAction(mode.first);
+        action->setCheckable(true);
+        action->setChecked(mode.second == m_videoManager->proxyScale());
+        proxyGroup->addAction(action);
+        int divisor = mode.second;
+        connect(action, &QAction::triggered, this, [this, divisor]() {
+            m_videoManager->setProxyScale(divisor);
+        });
+    }
+
+    viewMenu->addSeparator();
+
+    auto* cacheStatsAction = viewMenu->addAction(tr("Frame &Cache Statistics..."));
+    connect(cacheStatsAction, &QAction::triggered, this, [this]() {
+        auto stats = m_videoManager->cacheStats();
+        unsigned long long lookups = stats.hits + stats.misses;
+        double hitRate = lookups ? 100.0 * stats.hits / lookups : 0.0;
+        QMessageBox::information(this, tr("Frame Cache"),
+            tr("Cached frames: %1\nMemory: %2 / %3 MB\nHits: %4\nMisses: %5\nHit rate: %6%")
+                .arg(stats.frames)
+                .arg(stats.bytes >> 20)
+                .arg(stats.budget >> 20)
+                .arg(stats.hits)
+                .arg(stats.misses)
+                .arg(hitRate, 0, 'f', 1));
+    });
+
+    auto* cacheBudgetAction = viewMenu->addAction(tr("Set Frame Cache &Budget..."));
+    connect(cacheBudgetAction, &QAction::triggered, this, [this]() {
+        bool ok = false;
+        int mb = QInputDialog::getInt(this, tr("Frame Cache Budget"),
+                                      tr("Memory for decoded frames (MB):"),
+                                      static_cast<int>(m_videoManager->cacheStats().budget >> 20),
+                                      0, 1 << 20, 256, &ok);
+        if (ok)
+            m_videoManager->setCacheBudget(static_cast<size_t>(mb) << 20);
+    });
 }
 
 void MainWindow::connectSignals()
@@ -100,14 +216,49 @@ void MainWindow::connectSignals()
     connect(m_controlBar, &ControlBar::acceptClicked, this, &MainWindow::onAccept);
     connect(m_controlBar, &ControlBar::undoClicked, this, &MainWindow::onUndo);
     connect(m_controlBar, &ControlBar::frameSliderChanged, this, &MainWindow::onFrameSliderChanged);
+    connect(m_data, &AnnotationData::segmentsChanged, this, [this]() {
+        m_controlBar->setCoverage(m_data->segmentIndex().coverage());
+    });
+    // The view keeps its own copy of the labels, refreshed only when they
+    // change rather than with every overlay
+    connect(m_data, &AnnotationData::labelsChanged, this, [this]() {
+        m_videoWidget->setLabels(m_data->labels());
+    });
+    m_videoWidget->setLabels(m_data->labels());
+    connect(m_controlBar, &ControlBar::frameSliderReleased, this, [this](int frame) {
+        // Back to full resolution once the user stops dragging
+        if (m_state == STATE_IDLE)
+            onFrameSliderChanged(frame);
+    });
+
+    // Scrub requests complete asynchronously; only the latest one arrives
+    connect(m_videoManager, &VideoManager::frameReady,
+            this, [this](int /*frameIndex*/, const cv::Mat& frame) {
+                if (m_state == STATE_IDLE)
+                    m_videoWidget->displayFrame(frame, m_videoManager->frameSize());
+            });
 
     // Tracking engine
     connect(m_trackingEngine, &TrackingEngine::frameTracked,
             this, &MainWindow::onFrameTracked);
+    connect(m_renderer, &FrameRenderer::frameRendered, this,
+            [this](const QImage& image, const FrameAnnotationPtr& annotation) {
+                // Frames still queued when tracking was accepted or undone
+                if (m_state == STATE_TRACKING || m_state == STATE_PAUSED) {
+                    m_videoWidget->displayImage(image);
+                    m_videoWidget->setOverlay(annotation);
+                    m_controlBar->setCurrentFrame(annotation->frameIndex);
+                }
+                m_renderer->frameDisplayed();
+            });
+    connect(m_statsTimer, &QTimer::timeout, this, &MainWindow::updatePipelineStats);
+    connect(m_trackingEngine, &TrackingEngine::speedMeasured,
+            m_controlBar, &ControlBar::setTrackerSpeeds);
     connect(m_trackingEngine, &TrackingEngine::trackingFinished,
             this, &MainWindow::onTrackingFinished);
     connect(m_trackingEngine, &TrackingEngine::trackingError,
             this, [this](const QString& msg) {
+                m_statsTimer->stop();
                 QMessageBox::warning(this, tr("Tracking Error"), msg);
                 m_state = STATE_PAUSED;
                 updateButtonStates();
@@ -121,6 +272,12 @@ void MainWindow::connectSignals()
     connect(m_resultPanel, &ResultPanel::exportMotRequested,
             this, &MainWindow::onExportMotRequested);
 
+    // Background sessions
+    connect(m_sessionPanel, &SessionPanel::acceptRequested,
+            this, &MainWindow::onSessionAccepted);
+    connect(m_sessionPanel, &SessionPanel::cancelRequested,
+            this, &MainWindow::onSessionDiscarded);
+
     // Video widget box drawn / changed
     connect(m_videoWidget, &VideoWidget::boxDrawn,
             this, &MainWindow::onBoxDrawn);
@@ -138,26 +295,32 @@ void MainWindow::connectSignals()
         const auto& seg = m_data->segments()[m_playbackSegmentIndex];
         if (m_playbackFrame > seg.endFrame) {
             m_playbackTimer->stop();
+            displayFrameAt(seg.endFrame);
             statusBar()->showMessage(tr("Playback finished."));
             m_state = STATE_IDLE;
             updateButtonStates();
             return;
         }
 
-        cv::Mat frame = m_videoManager->getFrame(m_playbackFrame);
-        m_videoWidget->displayFrame(frame);
+        cv::Mat frame = m_videoManager->getProxyFrame(m_playbackFrame);
+        m_videoWidget->displayFrame(frame, m_videoManager->frameSize());
 
-        // Find annotation for this frame
-        for (const auto& fa : seg.annotations) {
-            if (fa.frameIndex == m_playbackFrame) {
-                m_videoWidget->setOverlayBoxes(fa.boxes, m_data->labels());
-                break;
-            }
-        }
+        if (seg.boxes.containsFrame(m_playbackFrame))
+            m_videoWidget->setOverlayBoxes(seg.boxes.boxesAt(m_playbackFrame));
 
         m_controlBar->setCurrentFrame(m_playbackFrame);
         m_playbackFrame++;
     });
+
+    // Reverse playback walks back through VideoManager's reverse buffer
+    connect(m_reverseTimer, &QTimer::timeout, this, [this]() {
+        int f = m_videoManager->currentFrameIndex() - 1;
+        if (m_state != STATE_IDLE || f < 0) {
+            m_reverseTimer->stop();
+            return;
+        }
+        displayFrameAt(f);
+    });
 }
 
 void MainWindow::updateButtonStates()
@@ -206,9 +369,21 @@ void MainWindow::displayFrameAt(int frameIndex)
     if (!frame.empty()) {
         m_videoWidget->displayFrame(frame);
         m_controlBar->setCurrentFrame(frameIndex);
+        if (m_state == STATE_IDLE)
+            showGroundTruth(frameIndex);
     }
 }
 
+void MainWindow::showGroundTruth(int frameIndex)
+{
+    // Accepted boxes on this frame, found through the segment index
+    std::vector<BoundingBox> boxes = m_data->groundTruthAt(frameIndex);
+    if (boxes.empty())
+        m_videoWidget->clearOverlayBoxes();
+    else
+        m_videoWidget->setOverlayBoxes(std::move(boxes));
+}
+
 void MainWindow::onOpenVideo()
 {
     QString path = QFileDialog::getOpenFileName(
@@ -217,13 +392,91 @@ void MainWindow::onOpenVideo()
 
     if (path.isEmpty()) return;
 
+    openVideo(path);
+}
+
+void MainWindow::onOpenProject()
+{
+    QString path = QFileDialog::getOpenFileName(
+        this, tr("Open Project"), QString(),
+        tr("Projects (*.%1);;All Files (*)").arg(ProjectFile::suffix()));
+
+    if (path.isEmpty()) return;
+
+    if (m_state == STATE_TRACKING)
+        onStop();
+    m_playbackTimer->stop();
+
+    QString videoPath;
+    if (!ProjectFile::load(path, *m_data, &videoPath)) {
+        QMessageBox::critical(this, tr("Error"),
+                              tr("Failed to open project file: %1").arg(path));
+        return;
+    }
+    m_projectPath = path;
+    m_mappedProjectPath = path;
+
+    if (!videoPath.isEmpty() && videoPath != m_videoManager->filePath()) {
+        if (!openVideo(videoPath)) {
+            statusBar()->showMessage(tr("Opened project %1; open its video to play segments back.")
+                                         .arg(path));
+            return;
+        }
+    } else if (m_state != STATE_NO_VIDEO) {
+        // The loaded session replaced whatever was being tracked
+        m_trackingEngine->reset();
+        m_renderer->clear();
+        m_resumeFrame = -1;
+        m_videoWidget->clearOverlayBoxes();
+        m_state = STATE_IDLE;
+        updateButtonStates();
+        showGroundTruth(m_videoManager->currentFrameIndex());
+    }
+
+    statusBar()->showMessage(tr("Opened project %1 (%2 segments).")
+                                 .arg(path).arg(m_data->segments().size()));
+}
+
+void MainWindow::onSaveProject()
+{
+    QString path = QFileDialog::getSaveFileName(
+        this, tr("Save Project"),
+        m_projectPath.isEmpty() ? QStringLiteral("project.") + ProjectFile::suffix() : m_projectPath,
+        tr("Projects (*.%1)").arg(ProjectFile::suffix()));
+
+    if (path.isEmpty()) return;
+
+    // Segments loaded from a project still map it, and a mapped file cannot
+    // be replaced everywhere
+    if (!m_mappedProjectPath.isEmpty() &&
+        QFileInfo(path).absoluteFilePath() == QFileInfo(m_mappedProjectPath).absoluteFilePath()) {
+        m_data->detachSegments();
+        m_mappedProjectPath.clear();
+    }
+
+    if (!ProjectFile::save(path, *m_data, m_videoManager->filePath())) {
+        QMessageBox::critical(this, tr("Error"), tr("Failed to save project file: %1").arg(path));
+        return;
+    }
+    m_projectPath = path;
+    statusBar()->showMessage(tr("Project saved to %1.").arg(path));
+}
+
+bool MainWindow::openVideo(const QString& path)
+{
     if (!m_videoManager->openVideo(path)) {
         QMessageBox::critical(this, tr("Error"),
                               tr("Failed to open video file: %1").arg(path));
-        return;
+        return false;
     }
 
     m_trackingEngine->reset();
+    m_renderer->clear();
+    m_interpolator->clear();
+    m_keyframeTracks.clear();
+    m_resumeFrame = -1;
+    while (!m_sessions.empty())
+        onSessionDiscarded(m_sessions.front()->id());
     m_data->clearActiveAnnotations();
     m_videoWidget->clearUserBoxes();
     m_videoWidget->clearOverlayBoxes();
@@ -240,64 +493,290 @@ void MainWindow::onOpenVideo()
                                  .arg(path)
                                  .arg(m_videoManager->totalFrames())
                                  .arg(m_videoManager->fps(), 0, 'f', 1));
+    return true;
 }
 
 void MainWindow::onRun()
 {
-    if (m_state == STATE_PAUSED && !m_videoWidget->userDrawnBoxes().empty()) {
-        // User drew new boxes after stopping - re-initialize with new boxes
-        // Accept previous work first is handled by user explicitly clicking Accept
+    if (m_state == STATE_PAUSED && m_resumeFrame >= 0) {
+        // Rewound: continue the same tracks from the (corrected) checkpoint
+        resumeTracking();
+        return;
     }
 
+    std::vector<BoundingBox> initialBoxes;
+    if (!takeUserBoxes(initialBoxes))
+        return;
+
+    // The boxes were drawn on the frame the slider shows, which may still
+    // be on its way from the decoder
+    cv::Mat frame = m_videoManager->settleRequestedFrame();
+    int currentFrame = m_videoManager->currentFrameIndex();
+
+    m_data->setTrackingStartFrame(currentFrame);
+
+    // Store initial frame annotation
+    auto initial = std::make_shared<FrameAnnotation>();
+    initial->frameIndex = currentFrame;
+    initial->boxes = initialBoxes;
+    m_data->addFrameAnnotation(std::move(initial));
+
+    configureEngine(m_trackingEngine);
+    m_trackingEngine->initialize(frame, currentFrame, initialBoxes);
+    m_trackingEngine->start();
+    m_statsClock.invalidate();
+    updatePipelineStats();
+    m_statsTimer->start();
+
+    m_videoWidget->clearUserBoxes();
+    m_state = STATE_TRACKING;
+    updateButtonStates();
+
+    statusBar()->showMessage(tr("Tracking %1 object(s)...").arg(initialBoxes.size()));
+}
+
+void MainWindow::onRunInBackground()
+{
+    if (m_state != STATE_IDLE)
+        return;
+
+    std::vector<BoundingBox> initialBoxes;
+    if (!takeUserBoxes(initialBoxes))
+        return;
+
+    // A session can be limited to a time range, e.g. one per scene
+    cv::Mat frame = m_videoManager->settleRequestedFrame();
+    int currentFrame = m_videoManager->currentFrameIndex();
+    bool ok = false;
+    int stopFrame = QInputDialog::getInt(this, tr("Track in Background"),
+                                         tr("Track forward until frame:"),
+                                         m_videoManager->totalFrames() - 1, currentFrame,
+                                         m_videoManager->totalFrames() - 1, 1, &ok);
+    if (!ok)
+        return;
+
+    auto* session = new TrackingSession(m_nextSessionId++, m_videoManager, this);
+    configureEngine(session->engine());
+    session->engine()->setStopFrame(stopFrame);
+    session->start(frame, currentFrame, initialBoxes);
+    m_sessions.push_back(session);
+    m_sessionPanel->addSession(session);
+
+    // Drawing continues right away; the session runs on its own threads
+    m_videoWidget->clearUserBoxes();
+    updateButtonStates();
+
+    statusBar()->showMessage(tr("Session %1 tracking %2 object(s) in the background.")
+                                 .arg(session->id()).arg(initialBoxes.size()));
+}
+
+void MainWindow::onRewind()
+{
+    if (m_state == STATE_TRACKING)
+        onStop();
+    if (m_state != STATE_PAUSED)
+        return;
+
+    int first = m_data->trackingStartFrame();
+    int last = m_trackingEngine->currentTrackingFrame();
+    bool ok = false;
+    int frame = QInputDialog::getInt(this, tr("Rewind Tracking"),
+                                     tr("Rewind to frame (%1-%2):").arg(first).arg(last),
+                                     m_videoManager->currentFrameIndex(), first, last, 1, &ok);
+    if (!ok)
+        return;
+
+    int checkpointFrame = -1;
+    std::vector<BoundingBox> boxes = m_trackingEngine->checkpoint(frame, &checkpointFrame);
+    if (boxes.empty())
+        return;
+
+    // Trackers restart right away, so Run without edits just carries on
+    m_trackingEngine->resumeFrom(checkpointFrame, boxes);
+    m_renderer->clear();
+    m_data->truncateActiveAnnotations(checkpointFrame);
+
+    displayFrameAt(checkpointFrame);
+    m_videoWidget->clearOverlayBoxes();
+    std::vector<QRectF> rects;
+    std::vector<int> trackIds;
+    for (const auto& box : boxes) {
+        rects.push_back(box.rect);
+        trackIds.push_back(box.trackId);
+    }
+    m_videoWidget->setUserBoxes(rects, trackIds);
+    m_resumeFrame = checkpointFrame;
+    m_resumeBoxes = boxes;
+
+    statusBar()->showMessage(tr("Rewound to frame %1. Correct the boxes and Run to resume.")
+                                 .arg(checkpointFrame));
+}
+
+void MainWindow::resumeTracking()
+{
     auto userBoxes = m_videoWidget->userDrawnBoxes();
+    auto trackIds = m_videoWidget->userBoxTrackIds();
     if (userBoxes.empty()) {
         QMessageBox::information(this, tr("Info"),
                                  tr("Please draw at least one bounding box on the video."));
         return;
     }
 
+    // Boxes from the checkpoint keep their track; boxes drawn since start
+    // tracks of their own
+    auto checkpointBox = [this](int trackId) -> const BoundingBox* {
+        for (const auto& box : m_resumeBoxes)
+            if (box.trackId == trackId)
+                return &box;
+        return nullptr;
+    };
     int labelId = m_labelPanel->selectedLabelId();
-    if (labelId < 0) {
+    bool drawn = std::any_of(trackIds.begin(), trackIds.end(),
+                             [&](int id) { return !checkpointBox(id); });
+    if (drawn && labelId < 0) {
         QMessageBox::information(this, tr("Info"),
                                  tr("Please add and select a label first."));
         return;
     }
+    std::vector<BoundingBox> boxes;
+    for (size_t i = 0; i < userBoxes.size(); ++i) {
+        BoundingBox box;
+        if (const BoundingBox* kept = checkpointBox(trackIds[i])) {
+            box = *kept;
+        } else {
+            box.trackId = m_data->nextTrackId();
+            box.labelId = labelId;
+        }
+        box.rect = userBoxes[i];
+        box.confidence = 1.0;
+        boxes.push_back(box);
+    }
+
+    m_trackingEngine->resumeFrom(m_resumeFrame, boxes);
+    AnnotationData::UpdateBatch batch(m_data);
+    m_data->truncateActiveAnnotations(m_resumeFrame - 1);
+    auto resumed = std::make_shared<FrameAnnotation>();
+    resumed->frameIndex = m_resumeFrame;
+    resumed->boxes = boxes;
+    m_data->addFrameAnnotation(std::move(resumed));
+
+    m_trackingEngine->start();
+    m_statsClock.invalidate();
+    updatePipelineStats();
+    m_statsTimer->start();
+
+    int resumed = m_resumeFrame;
+    m_resumeFrame = -1;
+    m_resumeBoxes.clear();
+    m_videoWidget->clearUserBoxes();
+    m_state = STATE_TRACKING;
+    updateButtonStates();
+
+    statusBar()->showMessage(tr("Resumed tracking %1 object(s) from frame %2...")
+                                 .arg(boxes.size()).arg(resumed));
+}
+
+void MainWindow::onSessionAccepted(int id)
+{
+    TrackingSession* session = takeSession(id);
+    if (!session)
+        return;
+
+    session->stop();
+    const ResultSegment& seg = m_data->acceptSegment(makeSegment(session->takeAnnotations()));
+    session->deleteLater();
+
+    statusBar()->showMessage(tr("Session %1 saved as '%2' (frames %3-%4).")
+                                 .arg(id).arg(seg.title).arg(seg.startFrame).arg(seg.endFrame));
+}
+
+void MainWindow::onSessionDiscarded(int id)
+{
+    TrackingSession* session = takeSession(id);
+    if (!session)
+        return;
+
+    session->stop();
+    session->deleteLater();
+    statusBar()->showMessage(tr("Session %1 discarded.").arg(id));
+}
+
+TrackingSession* MainWindow::takeSession(int id)
+{
+    auto it = std::find_if(m_sessions.begin(), m_sessions.end(),
+                           [id](TrackingSession* s) { return s->id() == id; });
+    if (it == m_sessions.end())
+        return nullptr;
+
+    TrackingSession* session = *it;
+    m_sessions.erase(it);
+    m_sessionPanel->removeSession(id);
+    return session;
+}
+
+bool MainWindow::takeUserBoxes(std::vector<BoundingBox>& boxes)
+{
+    auto userBoxes = m_videoWidget->userDrawnBoxes();
+    if (userBoxes.empty()) {
+        QMessageBox::information(this, tr("Info"),
+                                 tr("Please draw at least one bounding box on the video."));
+        return false;
+    }
+
+    int labelId = m_labelPanel->selectedLabelId();
+    if (labelId < 0) {
+        QMessageBox::information(this, tr("Info"),
+                                 tr("Please add and select a label first."));
+        return false;
+    }
 
     // Create BoundingBox objects from user-drawn rects
-    std::vector<BoundingBox> initialBoxes;
     for (const auto& rect : userBoxes) {
         BoundingBox box;
         box.trackId = m_data->nextTrackId();
         box.labelId = labelId;
         box.rect = rect;
         box.confidence = 1.0;
-        initialBoxes.push_back(box);
+        boxes.push_back(box);
     }
+    return true;
+}
 
-    int currentFrame = m_videoManager->currentFrameIndex();
-    cv::Mat frame = m_videoManager->currentFrame();
-
-    m_data->setTrackingStartFrame(currentFrame);
-
-    // Store initial frame annotation
-    FrameAnnotation fa;
-    fa.frameIndex = currentFrame;
-    fa.boxes = initialBoxes;
-    m_data->addFrameAnnotation(fa);
-
-    m_trackingEngine->initialize(frame, currentFrame, initialBoxes);
-    m_trackingEngine->start();
+void MainWindow::configureEngine(TrackingEngine* engine)
+{
+    engine->setBackend(m_controlBar->selectedBackend());
+    engine->setTrackingScale(m_controlBar->trackingScale());
+    engine->setStride(m_controlBar->trackingStride());
+    engine->setFpsBudget(m_controlBar->fpsBudget());
+    engine->setBidirectional(m_controlBar->trackBothDirections());
+    engine->setConsistencyScoring(m_controlBar->consistencyScoring());
+}
 
-    m_videoWidget->clearUserBoxes();
-    m_state = STATE_TRACKING;
-    updateButtonStates();
+ResultSegment MainWindow::makeSegment(const std::vector<FrameAnnotationPtr>& annotations)
+{
+    ResultSegment seg;
+    seg.segmentId = m_data->nextSegmentId();
+    seg.title = QString("video%1").arg(seg.segmentId);
+    if (!annotations.empty()) {
+        seg.startFrame = annotations.front()->frameIndex;
+        seg.endFrame = annotations.back()->frameIndex;
+    }
+    seg.boxes = BoxTable::fromAnnotations(annotations);
 
-    statusBar()->showMessage(tr("Tracking %1 object(s)...").arg(initialBoxes.size()));
+    // Thumbnail of the first frame, read without disturbing the current
+    // frame or a scrub request in flight
+    cv::Mat firstFrame = m_videoManager->peekFrame(seg.startFrame);
+    if (!firstFrame.empty()) {
+        seg.thumbnail = FrameConverter::matToQImage(firstFrame)
+                            .scaled(120, 80, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+    return seg;
 }
 
 void MainWindow::onStop()
 {
     m_trackingEngine->stop();
+    m_statsTimer->stop();
     m_state = STATE_PAUSED;
     updateButtonStates();
 
@@ -307,29 +786,21 @@ void MainWindow::onStop()
 
 void MainWindow::onAccept()
 {
-    auto& active = m_data->activeAnnotations();
-    if (active.empty()) {
+    if (m_data->activeAnnotations().empty()) {
         QMessageBox::information(this, tr("Info"), tr("No tracked data to accept."));
         return;
     }
 
-    ResultSegment seg;
-    seg.segmentId = static_cast<int>(m_data->segments().size());
-    seg.title = QString("video%1").arg(seg.segmentId);
-    seg.startFrame = m_data->trackingStartFrame();
-    seg.endFrame = m_trackingEngine->currentTrackingFrame();
-    seg.annotations = active;
+    // Backward results arrive interleaved with forward ones
+    m_data->sortActiveAnnotations();
 
-    // Capture thumbnail from first frame
-    cv::Mat firstFrame = m_videoManager->getFrame(seg.startFrame);
-    if (!firstFrame.empty()) {
-        seg.thumbnail = FrameConverter::matToQImage(firstFrame)
-                            .scaled(120, 80, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-    }
-
-    m_data->acceptSegment(seg);
+    const ResultSegment& seg = m_data->acceptSegment(makeSegment(m_data->activeAnnotations()));
     m_data->clearActiveAnnotations();
     m_trackingEngine->reset();
+    m_renderer->clear();
+    m_interpolator->clear();
+    m_resumeFrame = -1;
+    m_keyframeTracks.clear();
     m_videoWidget->clearOverlayBoxes();
 
     m_state = STATE_IDLE;
@@ -344,6 +815,8 @@ void MainWindow::onUndo()
     int startFrame = m_data->trackingStartFrame();
 
     m_trackingEngine->reset();
+    m_renderer->clear();
+    m_resumeFrame = -1;
     m_data->clearActiveAnnotations();
     m_videoWidget->clearOverlayBoxes();
     m_videoWidget->clearUserBoxes();
@@ -357,23 +830,62 @@ void MainWindow::onUndo()
     statusBar()->showMessage(tr("Tracking undone. Returned to frame %1.").arg(startFrame));
 }
 
-void MainWindow::onFrameTracked(int frameIndex, const std::vector<BoundingBox>& boxes)
+void MainWindow::onFrameTracked(const FrameAnnotationPtr& annotation, const cv::Mat& frame)
 {
-    // Store annotation
-    FrameAnnotation fa;
-    fa.frameIndex = frameIndex;
-    fa.boxes = boxes;
-    m_data->addFrameAnnotation(fa);
+    // Results queued up behind each other (a replay, or a backlog while the
+    // GUI was busy) are announced together once the event loop gets past them
+    if (!m_frameBatchOpen) {
+        m_frameBatchOpen = true;
+        m_data->beginUpdate();
+        QTimer::singleShot(0, this, [this]() {
+            m_frameBatchOpen = false;
+            m_data->endUpdate();
+        });
+    }
+
+    // The record is shared with the engine and the renderer, not copied
+    m_data->addFrameAnnotation(annotation);
+    int frameIndex = annotation->frameIndex;
+
+    // The view follows the forward direction; backward results and frames
+    // interpolated between strided updates are only stored
+    if (frameIndex < m_data->trackingStartFrame() || frame.empty())
+        return;
+
+    // The frame was decoded on the tracking thread; conversion and display
+    // happen in the render stage, which drops frames rather than stall
+    m_videoManager->setCurrentFrame(frameIndex, frame);
+    m_renderer->submit(annotation, frame);
+}
 
-    // Update display
-    cv::Mat frame = m_videoManager->currentFrame();
-    m_videoWidget->displayFrame(frame);
-    m_videoWidget->setOverlayBoxes(boxes, m_data->labels());
-    m_controlBar->setCurrentFrame(frameIndex);
+void MainWindow::updatePipelineStats()
+{
+    StageStats stats[3] = { m_trackingEngine->decodeStats(),
+                            m_trackingEngine->trackStats(),
+                            m_renderer->stats() };
+    const QString names[3] = { tr("Decode"), tr("Track"), tr("Render") };
+
+    double seconds = m_statsClock.isValid() ? m_statsClock.restart() / 1000.0 : 0.0;
+    if (!m_statsClock.isValid())
+        m_statsClock.start();
+
+    QStringList parts;
+    for (int i = 0; i < 3; ++i) {
+        double fps = seconds > 0 ? (stats[i].processed - m_lastStats[i].processed) / seconds
+                                 : 0.0;
+        QString part = tr("%1 %2 fps (%3/%4)").arg(names[i]).arg(fps, 0, 'f', 0)
+                           .arg(stats[i].depth).arg(stats[i].capacity);
+        if (stats[i].dropped > 0)
+            part += tr(", %1 dropped").arg(stats[i].dropped);
+        parts << part;
+        m_lastStats[i] = stats[i];
+    }
+    m_pipelineLabel->setText(parts.join(QStringLiteral(" | ")));
 }
 
 void MainWindow::onTrackingFinished()
 {
+    m_statsTimer->stop();
     m_state = STATE_PAUSED;
     updateButtonStates();
     statusBar()->showMessage(tr("Tracking reached end of video. Accept to save results."));
@@ -382,7 +894,15 @@ void MainWindow::onTrackingFinished()
 void MainWindow::onFrameSliderChanged(int frame)
 {
     if (m_state == STATE_IDLE || m_state == STATE_NO_VIDEO) {
-        displayFrameAt(frame);
+        // Never blocks: shows the nearest cached frame now, and the exact
+        // frame through frameReady once decoded. Intermediate positions of a
+        // fast drag are dropped by the decoder.
+        cv::Mat preview = m_videoManager->requestFrame(
+            frame, m_controlBar->isSliderDragging());
+        if (!preview.empty())
+            m_videoWidget->displayFrame(preview, m_videoManager->frameSize());
+        if (m_state == STATE_IDLE)
+            showGroundTruth(frame);
     }
 }
 
@@ -456,6 +976,81 @@ void MainWindow::onBoxDrawn(const QRectF& /*videoRect*/)
     updateButtonStates();
 }
 
+void MainWindow::onSetKeyframe()
+{
+    if (m_state != STATE_IDLE)
+        return;
+
+    auto userBoxes = m_videoWidget->userDrawnBoxes();
+    if (userBoxes.empty()) {
+        QMessageBox::information(this, tr("Info"),
+                                 tr("Please draw at least one bounding box on the video."));
+        return;
+    }
+
+    // The i-th box keeps the identity it got on the first keyframe; boxes
+    // drawn later start new tracks with the selected label
+    int labelId = m_labelPanel->selectedLabelId();
+    if (userBoxes.size() > m_keyframeTracks.size() && labelId < 0) {
+        QMessageBox::information(this, tr("Info"),
+                                 tr("Please add and select a label first."));
+        return;
+    }
+    while (m_keyframeTracks.size() < userBoxes.size()) {
+        BoundingBox track;
+        track.trackId = m_data->nextTrackId();
+        track.labelId = labelId;
+        m_keyframeTracks.push_back(track);
+    }
+
+    FrameAnnotation keyframe;
+    keyframe.frameIndex = m_videoManager->currentFrameIndex();
+    for (size_t i = 0; i < userBoxes.size(); ++i) {
+        BoundingBox box = m_keyframeTracks[i];
+        box.rect = userBoxes[i];
+        box.confidence = 1.0;
+        keyframe.boxes.push_back(box);
+    }
+    m_interpolator->setKeyframe(keyframe);
+
+    statusBar()->showMessage(tr("Keyframe %1 set at frame %2. Move on, adjust the boxes and press K "
+                                "again; Ctrl+I fills the frames in between.")
+                                 .arg(m_interpolator->keyframes().size())
+                                 .arg(keyframe.frameIndex));
+}
+
+void MainWindow::onInterpolate()
+{
+    if (m_state != STATE_IDLE)
+        return;
+    if (m_interpolator->keyframes().size() < 2) {
+        QMessageBox::information(this, tr("Info"),
+                                 tr("Set boxes on at least two keyframes first (K)."));
+        return;
+    }
+
+    // Interpolated frames take the place of tracked ones, so Accept and
+    // Undo work unchanged
+    std::vector<FrameAnnotationPtr> annotations;
+    for (FrameAnnotation& fa : m_interpolator->interpolate())
+        annotations.push_back(std::make_shared<FrameAnnotation>(std::move(fa)));
+    int startFrame = annotations.front()->frameIndex;
+    int endFrame = annotations.back()->frameIndex;
+    m_data->setActiveAnnotations(std::move(annotations));
+    m_data->setTrackingStartFrame(startFrame);
+
+    m_videoWidget->clearUserBoxes();
+    displayFrameAt(startFrame);
+    m_videoWidget->setOverlay(m_data->activeAnnotations().front());
+
+    m_state = STATE_PAUSED;
+    updateButtonStates();
+
+    statusBar()->showMessage(tr("Interpolated frames %1-%2 (%3). Accept to save, Undo to adjust keyframes.")
+                                 .arg(startFrame).arg(endFrame)
+                                 .arg(InterpolationEngine::modelName(m_interpolator->model())));
+}
+
 void MainWindow::keyPressEvent(QKeyEvent* event)
 {
     
@@ -493,12 +1088,21 @@ void MainWindow::keyPressEvent(QKeyEvent* event)
         break;
     case Qt::Key_Left:
         if (m_state == STATE_IDLE && m_videoManager->isOpened()) {
+            if (event->modifiers() & Qt::ShiftModifier) {
+                if (m_reverseTimer->isActive())
+                    m_reverseTimer->stop();
+                else
+                    m_reverseTimer->start(static_cast<int>(1000.0 / m_videoManager->fps()));
+                break;
+            }
+            m_reverseTimer->stop();
             int f = std::max(0, m_videoManager->currentFrameIndex() - 1);
             displayFrameAt(f);
         }
         break;
     case Qt::Key_Right:
         if (m_state == STATE_IDLE && m_videoManager->isOpened()) {
+            m_reverseTimer->stop();
             int f = std::min(m_videoManager->totalFrames() - 1,
                              m_videoManager->currentFrameIndex() + 1);
             displayFrameAt(f);
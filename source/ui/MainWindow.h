@@ -1,7 +1,12 @@
 #pragma once
 
+#include <QElapsedTimer>
 #include <QMainWindow>
 #include <QTimer>
+#include <opencv2/core.hpp>
+#include <vector>
+#include "core/AnnotationData.h"
+#include "core/StageStats.h"
 
 class VideoWidget;
 class LabelPanel;
@@ -10,6 +15,11 @@ class ControlBar;
 class AnnotationData;
 class VideoManager;
 class TrackingEngine;
+class InterpolationEngine;
+class FrameRenderer;
+class SessionPanel;
+class TrackingSession;
+class QLabel;
 
 class MainWindow : public QMainWindow {
     Q_OBJECT
@@ -22,24 +32,40 @@ protected:
 
 private slots:
     void onOpenVideo();
+    void onOpenProject();
+    void onSaveProject();
     void onRun();
     void onStop();
     void onAccept();
     void onUndo();
-    void onFrameTracked(int frameIndex, const std::vector<struct BoundingBox>& boxes);
+    void onFrameTracked(const FrameAnnotationPtr& annotation, const cv::Mat& frame);
     void onTrackingFinished();
     void onFrameSliderChanged(int frame);
     void onSegmentDoubleClicked(int index);
     void onMergeRequested();
     void onExportMotRequested();
     void onBoxDrawn(const QRectF& videoRect);
+    void onSetKeyframe();
+    void onRunInBackground();
+    void onRewind();
+    void onSessionAccepted(int id);
+    void onSessionDiscarded(int id);
+    void onInterpolate();
 
 private:
     void setupLayout();
     void setupMenuBar();
+    bool openVideo(const QString& path);
     void connectSignals();
     void updateButtonStates();
     void displayFrameAt(int frameIndex);
+    void showGroundTruth(int frameIndex);
+    void updatePipelineStats();
+    bool takeUserBoxes(std::vector<BoundingBox>& boxes);
+    void resumeTracking();
+    void configureEngine(TrackingEngine* engine);
+    ResultSegment makeSegment(const std::vector<FrameAnnotationPtr>& annotations);
+    TrackingSession* takeSession(int id);
 
     enum AppState { STATE_NO_VIDEO, STATE_IDLE, STATE_TRACKING, STATE_PAUSED };
     AppState m_state = STATE_NO_VIDEO;
@@ -48,15 +74,46 @@ private:
     VideoWidget*  m_videoWidget;
     LabelPanel*   m_labelPanel;
     ResultPanel*  m_resultPanel;
+    SessionPanel* m_sessionPanel;
     ControlBar*   m_controlBar;
 
     // Core
     AnnotationData*  m_data;
     VideoManager*    m_videoManager;
     TrackingEngine*  m_trackingEngine;
+    InterpolationEngine* m_interpolator;
+    QString          m_projectPath; // last opened or saved
+    QString          m_mappedProjectPath; // opened, and still viewed by segments
+
+    // Checkpoint rewound to, whose boxes the user may correct before Run
+    // resumes tracking; -1 when not rewound
+    int                      m_resumeFrame = -1;
+    std::vector<BoundingBox> m_resumeBoxes;
+
+    // Tracking sessions running or finished in the background
+    std::vector<TrackingSession*> m_sessions;
+    int                           m_nextSessionId = 1;
+
+    // Track identity of the user boxes, by drawing order, while keyframes
+    // are placed for interpolation
+    std::vector<BoundingBox> m_keyframeTracks;
 
     // Playback timer for viewing result segments
     QTimer*  m_playbackTimer;
     int      m_playbackSegmentIndex = -1;
     int      m_playbackFrame = 0;
+
+    // Reverse playback (Shift+Left) in idle mode
+    QTimer*  m_reverseTimer;
+
+    // Display stage of tracking and the per-stage readout in the status bar
+    FrameRenderer* m_renderer;
+    QTimer*        m_statsTimer;
+    QLabel*        m_pipelineLabel;
+    QElapsedTimer  m_statsClock;
+    StageStats     m_lastStats[3]; // decode, track, render
+
+    // Tracked frames stored during one event loop pass share one change
+    // notification
+    bool           m_frameBatchOpen = false;
 };
@@ -1,8 +1,9 @@
 #include "ResultPanel.h"
+#include "SegmentListModel.h"
 #include "core/AnnotationData.h"
 #include <QVBoxLayout>
 #include <QLabel>
-#include <QListWidget>
+#include <QListView>
 #include <QPushButton>
 
 ResultPanel::ResultPanel(AnnotationData* data, QWidget* parent)
@@ -14,10 +15,15 @@ ResultPanel::ResultPanel(AnnotationData* data, QWidget* parent)
     titleLabel->setStyleSheet("font-weight: bold; font-size: 14px;");
     layout->addWidget(titleLabel);
 
-    m_segmentList = new QListWidget;
+    // Rows are all the same size, which spares the view measuring each one
+    m_model = new SegmentListModel(m_data, this);
+    m_segmentList = new QListView;
+    m_segmentList->setModel(m_model);
     m_segmentList->setIconSize(QSize(120, 80));
-    m_segmentList->setViewMode(QListWidget::ListMode);
+    m_segmentList->setViewMode(QListView::ListMode);
     m_segmentList->setSpacing(4);
+    m_segmentList->setUniformItemSizes(true);
+    m_segmentList->setEditTriggers(QAbstractItemView::NoEditTriggers);
     layout->addWidget(m_segmentList, 1);
 
     m_mergeBtn = new QPushButton(tr("Merge && Export Video"));
@@ -27,37 +33,11 @@ ResultPanel::ResultPanel(AnnotationData* data, QWidget* parent)
 
     setFixedWidth(250);
 
-    connect(m_segmentList, &QListWidget::itemDoubleClicked,
-            this, &ResultPanel::onItemDoubleClicked);
+    connect(m_segmentList, &QListView::doubleClicked, this, [this](const QModelIndex& index) {
+        emit segmentDoubleClicked(index.row());
+    });
     connect(m_mergeBtn, &QPushButton::clicked,
             this, &ResultPanel::mergeRequested);
     connect(m_exportBtn, &QPushButton::clicked,
             this, &ResultPanel::exportMotRequested);
-    connect(m_data, &AnnotationData::segmentsChanged,
-            this, &ResultPanel::refreshList);
-}
-
-void ResultPanel::refreshList()
-{
-    m_segmentList->clear();
-    const auto& segments = m_data->segments();
-    for (size_t i = 0; i < segments.size(); ++i) {
-        const auto& seg = segments[i];
-        auto* item = new QListWidgetItem;
-        item->setText(seg.title);
-        item->setData(Qt::UserRole, static_cast<int>(i));
-        if (!seg.thumbnail.isNull()) {
-            item->setIcon(QIcon(QPixmap::fromImage(seg.thumbnail)));
-        }
-        m_segmentList->addItem(item);
-    }
-}
-
-void ResultPanel::onItemDoubleClicked()
-{
-    auto* item = m_segmentList->currentItem();
-    if (item) {
-        int index = item->data(Qt::UserRole).toInt();
-        emit segmentDoubleClicked(index);
-    }
 }
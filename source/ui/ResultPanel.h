@@ -2,9 +2,10 @@
 
 #include <QWidget>
 
-class QListWidget;
+class QListView;
 class QPushButton;
 class AnnotationData;
+class SegmentListModel;
 
 class ResultPanel : public QWidget {
     Q_OBJECT
@@ -16,13 +17,10 @@ signals:
     void mergeRequested();
     void exportMotRequested();
 
-private slots:
-    void refreshList();
-    void onItemDoubleClicked();
-
 private:
-    AnnotationData* m_data;
-    QListWidget*    m_segmentList;
-    QPushButton*    m_mergeBtn;
-    QPushButton*    m_exportBtn;
+    AnnotationData*   m_data;
+    SegmentListModel* m_model;
+    QListView*        m_segmentList;
+    QPushButton*      m_mergeBtn;
+    QPushButton*      m_exportBtn;
 };
@@ -0,0 +1,62 @@
+#include "SegmentListModel.h"
+#include <QPixmap>
+
+SegmentListModel::SegmentListModel(AnnotationData* data, QObject* parent)
+    : QAbstractListModel(parent)
+    , m_data(data)
+    , m_icons(data->segments().size())
+{
+    connect(m_data, &AnnotationData::segmentsChanged,
+            this, &SegmentListModel::onSegmentsChanged);
+}
+
+int SegmentListModel::rowCount(const QModelIndex& parent) const
+{
+    // Rows follow the announced changes, not segments() directly, so the
+    // count stays consistent while a change is being applied
+    return parent.isValid() ? 0 : static_cast<int>(m_icons.size());
+}
+
+QVariant SegmentListModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() >= rowCount())
+        return QVariant();
+    const ResultSegment& seg = m_data->segments()[index.row()];
+
+    switch (role) {
+    case Qt::DisplayRole:
+        return seg.title;
+    case Qt::DecorationRole: {
+        QIcon& icon = m_icons[index.row()];
+        if (icon.isNull() && !seg.thumbnail.isNull())
+            icon = QIcon(QPixmap::fromImage(seg.thumbnail));
+        return icon;
+    }
+    case Qt::ToolTipRole:
+        return tr("Frames %1-%2").arg(seg.startFrame).arg(seg.endFrame);
+    default:
+        return QVariant();
+    }
+}
+
+void SegmentListModel::onSegmentsChanged(const AnnotationData::Change& change)
+{
+    switch (change.kind) {
+    case AnnotationData::Change::Inserted:
+        beginInsertRows(QModelIndex(), change.first, change.first + change.count - 1);
+        m_icons.insert(m_icons.begin() + change.first, change.count, QIcon());
+        endInsertRows();
+        break;
+    case AnnotationData::Change::Removed:
+        beginRemoveRows(QModelIndex(), change.first, change.first + change.count - 1);
+        m_icons.erase(m_icons.begin() + change.first,
+                      m_icons.begin() + change.first + change.count);
+        endRemoveRows();
+        break;
+    case AnnotationData::Change::Reset:
+        beginResetModel();
+        m_icons.assign(m_data->segments().size(), QIcon());
+        endResetModel();
+        break;
+    }
+}
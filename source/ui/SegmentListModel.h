@@ -0,0 +1,25 @@
+#pragma once
+
+#include <QAbstractListModel>
+#include <QIcon>
+#include <vector>
+#include "core/AnnotationData.h"
+
+// Accepted segments as list rows, one per segment in AnnotationData order.
+// Follows segmentsChanged() row range by row range, so accepting or
+// removing a segment only touches that row; thumbnail icons are built the
+// first time a row is shown and kept until it goes away.
+class SegmentListModel : public QAbstractListModel {
+    Q_OBJECT
+public:
+    explicit SegmentListModel(AnnotationData* data, QObject* parent = nullptr);
+
+    int      rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+private:
+    void onSegmentsChanged(const AnnotationData::Change& change);
+
+    AnnotationData*            m_data;
+    mutable std::vector<QIcon> m_icons; // by row; null until first shown
+};
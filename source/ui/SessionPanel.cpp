@@ -0,0 +1,102 @@
+#include "SessionPanel.h"
+#include "core/TrackingSession.h"
+#include <QVBoxLayout>
+#include <QHBoxLayout>
+#include <QLabel>
+#include <QListWidget>
+#include <QPushButton>
+#include <QTimer>
+#include <algorithm>
+
+SessionPanel::SessionPanel(QWidget* parent)
+    : QWidget(parent)
+{
+    auto* layout = new QVBoxLayout(this);
+
+    auto* titleLabel = new QLabel(tr("Background Tracking"));
+    titleLabel->setStyleSheet("font-weight: bold; font-size: 14px;");
+    layout->addWidget(titleLabel);
+
+    m_sessionList = new QListWidget;
+    m_sessionList->setSpacing(2);
+    layout->addWidget(m_sessionList, 1);
+
+    auto* btnLayout = new QHBoxLayout;
+    m_acceptBtn = new QPushButton(tr("Accept"));
+    m_cancelBtn = new QPushButton(tr("Discard"));
+    btnLayout->addWidget(m_acceptBtn);
+    btnLayout->addWidget(m_cancelBtn);
+    layout->addLayout(btnLayout);
+
+    setFixedWidth(250);
+
+    // Progress is polled; sessions deliver hundreds of frames per second
+    m_refreshTimer = new QTimer(this);
+    m_refreshTimer->setInterval(500);
+
+    connect(m_refreshTimer, &QTimer::timeout, this, &SessionPanel::refreshList);
+    connect(m_acceptBtn, &QPushButton::clicked, this, [this]() {
+        int id = selectedId();
+        if (id >= 0)
+            emit acceptRequested(id);
+    });
+    connect(m_cancelBtn, &QPushButton::clicked, this, [this]() {
+        int id = selectedId();
+        if (id >= 0)
+            emit cancelRequested(id);
+    });
+}
+
+void SessionPanel::addSession(TrackingSession* session)
+{
+    m_sessions.push_back(session);
+    connect(session, &TrackingSession::stateChanged, this, &SessionPanel::refreshList);
+    refreshList();
+    m_refreshTimer->start();
+}
+
+void SessionPanel::removeSession(int id)
+{
+    m_sessions.erase(std::remove_if(m_sessions.begin(), m_sessions.end(),
+                                    [id](TrackingSession* s) { return s->id() == id; }),
+                     m_sessions.end());
+    refreshList();
+}
+
+void SessionPanel::refreshList()
+{
+    int selected = selectedId();
+    bool running = false;
+
+    m_sessionList->clear();
+    for (TrackingSession* session : m_sessions) {
+        QString state;
+        switch (session->state()) {
+        case TrackingSession::State::Running:  state = tr("running"); running = true; break;
+        case TrackingSession::State::Stopped:  state = tr("stopped"); break;
+        case TrackingSession::State::Finished: state = tr("done"); break;
+        case TrackingSession::State::Failed:   state = session->errorMessage(); break;
+        }
+
+        auto* item = new QListWidgetItem;
+        item->setText(tr("Session %1: %2 object(s)\nFrames %3-%4, %5")
+                          .arg(session->id())
+                          .arg(session->trackCount())
+                          .arg(session->firstFrame())
+                          .arg(session->lastFrame())
+                          .arg(state));
+        item->setData(Qt::UserRole, session->id());
+        m_sessionList->addItem(item);
+        if (session->id() == selected)
+            m_sessionList->setCurrentItem(item);
+    }
+
+    if (!running)
+        m_refreshTimer->stop();
+}
+
+int SessionPanel::selectedId() const
+{
+    auto* item = m_sessionList->currentItem();
+    return item ? item->data(Qt::UserRole).toInt() : -1;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <QWidget>
+#include <vector>
+
+class QListWidget;
+class QPushButton;
+class QTimer;
+class TrackingSession;
+
+// Background tracking sessions with their progress. Accepting one turns
+// its results into a segment; cancelling discards them.
+class SessionPanel : public QWidget {
+    Q_OBJECT
+public:
+    explicit SessionPanel(QWidget* parent = nullptr);
+
+    void addSession(TrackingSession* session);
+    void removeSession(int id);
+
+signals:
+    void acceptRequested(int id);
+    void cancelRequested(int id);
+
+private slots:
+    void refreshList();
+
+private:
+    int selectedId() const;
+
+    QListWidget*                  m_sessionList;
+    QPushButton*                  m_acceptBtn;
+    QPushButton*                  m_cancelBtn;
+    QTimer*                       m_refreshTimer;
+    std::vector<TrackingSession*> m_sessions;
+};
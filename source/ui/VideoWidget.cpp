@@ -30,12 +30,18 @@ void VideoWidget::setSelectedBox(int value) {
 	m_selectedBox = value;
 }
 
-void VideoWidget::displayFrame(const cv::Mat& frame)
+void VideoWidget::displayFrame(const cv::Mat& frame, const QSize& videoSize)
 {
-    m_displayImage = FrameConverter::matToQImage(frame);
+    displayImage(FrameConverter::matToQImage(frame), videoSize);
+}
+
+void VideoWidget::displayImage(const QImage& image, const QSize& videoSize)
+{
+    m_displayImage = image;
     if (!m_displayImage.isNull()) {
-        bool sizeChanged = (m_displayImage.size() != m_videoSize);
-        m_videoSize = m_displayImage.size();
+        QSize size = videoSize.isValid() ? videoSize : m_displayImage.size();
+        bool sizeChanged = (size != m_videoSize);
+        m_videoSize = size;
         if (sizeChanged) {
             m_zoomFactor = 1.0;
             initializePan();
@@ -45,17 +51,28 @@ void VideoWidget::displayFrame(const cv::Mat& frame)
     update();
 }
 
-void VideoWidget::setOverlayBoxes(const std::vector<BoundingBox>& boxes,
-                                   const std::vector<LabelDef>& labels)
+void VideoWidget::setOverlay(FrameAnnotationPtr annotation)
+{
+    m_overlay = std::move(annotation);
+    update();
+}
+
+void VideoWidget::setOverlayBoxes(std::vector<BoundingBox> boxes)
+{
+    auto overlay = std::make_shared<FrameAnnotation>();
+    overlay->boxes = std::move(boxes);
+    setOverlay(std::move(overlay));
+}
+
+void VideoWidget::setLabels(const std::vector<LabelDef>& labels)
 {
-    m_overlayBoxes = boxes;
     m_labels = labels;
     update();
 }
 
 void VideoWidget::clearOverlayBoxes()
 {
-    m_overlayBoxes.clear();
+    m_overlay.reset();
     update();
 }
 
@@ -75,19 +92,34 @@ void VideoWidget::setDrawingEnabled(bool enabled)
 void VideoWidget::clearUserBoxes()
 {
     m_userBoxes.clear();
+    m_userBoxTrackIds.clear();
     m_selectedBox = -1;
     m_dragMode    = DragNone;
     update();
 }
+
+void VideoWidget::setUserBoxes(const std::vector<QRectF>& boxes, const std::vector<int>& trackIds)
+{
+    m_userBoxes = boxes;
+    m_userBoxTrackIds = trackIds;
+    m_userBoxTrackIds.resize(m_userBoxes.size(), -1);
+    m_selectedBox = -1;
+    m_dragMode    = DragNone;
+    emit userBoxesChanged();
+    update();
+}
+
 void VideoWidget::removeSelectedUserbox(int index)
 {
 	m_userBoxes.erase(m_userBoxes.begin() + index);
+	m_userBoxTrackIds.erase(m_userBoxTrackIds.begin() + index);
 }
 
 void VideoWidget::removeLastUserBox()
 {
     if (m_userBoxes.empty()) return;
     m_userBoxes.pop_back();
+    m_userBoxTrackIds.pop_back();
     if (m_selectedBox >= static_cast<int>(m_userBoxes.size()))
         m_selectedBox = -1;
     emit userBoxesChanged();
@@ -269,7 +301,9 @@ void VideoWidget::paintEvent(QPaintEvent* event)
         painter.drawImage(m_displayRect, m_displayImage);
 
     // Overlay boxes (tracked / existing)
-    for (const auto& box : m_overlayBoxes) {
+    static const FrameAnnotation kNoOverlay;
+    const FrameAnnotation& overlay = m_overlay ? *m_overlay : kNoOverlay;
+    for (const auto& box : overlay.boxes) {
         QColor color = Qt::green;
         QString label;
         for (const auto& lbl : m_labels) {
@@ -477,6 +511,7 @@ void VideoWidget::mouseReleaseEvent(QMouseEvent* event)
                 QRectF(0, 0, m_videoSize.width(), m_videoSize.height()));
             if (videoRect.width() > 1 && videoRect.height() > 1) {
                 m_userBoxes.push_back(videoRect);
+                m_userBoxTrackIds.push_back(-1);
                 m_selectedBox = static_cast<int>(m_userBoxes.size()) - 1;
                 emit boxDrawn(videoRect);
             }
@@ -18,16 +18,25 @@ public:
     int getSelectedBox();
     explicit VideoWidget(QWidget* parent = nullptr);
 
-    void displayFrame(const cv::Mat& frame);
-    void setOverlayBoxes(const std::vector<BoundingBox>& boxes,
-                         const std::vector<LabelDef>& labels);
+    // videoSize is the full-resolution frame size when frame is a downscaled
+    // proxy; boxes and transforms always work in full-resolution coordinates
+    void displayFrame(const cv::Mat& frame, const QSize& videoSize = QSize());
+    void displayImage(const QImage& image, const QSize& videoSize = QSize());
+    // Tracked frames are shown without copying their boxes
+    void setOverlay(FrameAnnotationPtr annotation);
+    void setOverlayBoxes(std::vector<BoundingBox> boxes);
+    void setLabels(const std::vector<LabelDef>& labels);
     void clearOverlayBoxes();
     void setDrawingEnabled(bool enabled);
     void clearUserBoxes();
+    // trackIds, parallel to boxes, tie boxes being edited to existing tracks
+    void setUserBoxes(const std::vector<QRectF>& boxes, const std::vector<int>& trackIds = {});
     void removeLastUserBox();
     void removeSelectedUserbox(int index);
     void resetZoom();
     std::vector<QRectF> userDrawnBoxes() const { return m_userBoxes; }
+    // Track id of each user box, -1 for boxes drawn by hand
+    std::vector<int> userBoxTrackIds() const { return m_userBoxTrackIds; }
 
     // Coordinate conversion
     QRectF  widgetToVideo(const QRectF& widgetRect) const;
@@ -57,7 +66,7 @@ private:
     void updateCursorForPos(const QPointF& widgetPos);
 
     QImage                   m_displayImage;
-    std::vector<BoundingBox> m_overlayBoxes;
+    FrameAnnotationPtr       m_overlay;
     std::vector<LabelDef>    m_labels;
 
     // Drawing enabled flag
@@ -79,6 +88,7 @@ private:
     QRectF     m_dragBoxOrigRect; // video coords at drag start
 
     std::vector<QRectF> m_userBoxes; // video coordinates
+    std::vector<int>    m_userBoxTrackIds; // parallel to m_userBoxes
 
     // Display geometry
     QRectF m_displayRect;